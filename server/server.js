@@ -1,4 +1,6 @@
 const net = require('net');
+const dgram = require('dgram');
+const crypto = require('crypto');
 
 // 消息类型（与 C++ 客户端一致）
 const MessageType = {
@@ -40,12 +42,41 @@ const MessageType = {
   HostStartGame: 30,
   RoomInfo: 31,
   // 墙壁伤害同步
-  WallDamage: 32
+  WallDamage: 32,
+  // 批量消息：Batch + 若干个 [长度(2) + 消息]
+  Batch: 33,
+  // 客户端已收到登记回显，UDP 双向可用
+  UdpReady: 34,
+  // NPC 增量快照及其确认
+  NpcSnapshot: 35,
+  NpcSnapshotAck: 36,
+  // 客户端预测：输入和权威位置纠正
+  PlayerInput: 37,
+  PlayerCorrection: 38,
+  // 种子同步迷宫（只含生成参数和校验和）
+  MazeSeed: 39
 };
 
+// 长度前缀为 2 字节，单个包的最大长度
+const MAX_FRAME_SIZE = 0xFFFF;
+
 // 房间管理
 const rooms = new Map();
 
+// UDP 会话：会话ID -> TCP socket（在 ConnectAck 中下发给客户端）
+const sessions = new Map();
+
+// UDP 数据报：会话ID(4) + 序号(4) + 若干个 [长度(2) + 消息]
+const UDP_HEADER_SIZE = 8;
+
+function createSessionId() {
+  let id;
+  do {
+    id = crypto.randomBytes(4).readUInt32LE(0);
+  } while (id === 0 || sessions.has(id));
+  return id;
+}
+
 // 生成随机房间码（纯4位数字）
 function generateRoomCode() {
   const code = Math.floor(1000 + Math.random() * 9000).toString();
@@ -89,15 +120,66 @@ function sendRoomInfo(room) {
   }
 }
 
-// 发送消息给客户端
-function sendMessage(socket, data) {
-  const len = data.length;
-  const packet = Buffer.alloc(2 + len);
-  packet.writeUInt16LE(len, 0);
+// 写出一个带长度前缀的包
+function writeFrame(socket, data) {
+  const packet = Buffer.alloc(2 + data.length);
+  packet.writeUInt16LE(data.length, 0);
   data.copy(packet, 2);
   socket.write(packet);
 }
 
+// 把同一轮事件循环中发给某个客户端的消息合并成批量包
+function flushOutbox(socket) {
+  const messages = socket.outbox;
+  socket.outbox = null;
+  if (!messages || socket.destroyed || socket.writableEnded) return;
+
+  let batch = [];
+  let batchSize = 1;
+  const finishBatch = () => {
+    if (batch.length === 1) {
+      writeFrame(socket, batch[0]);
+    } else if (batch.length > 1) {
+      const data = Buffer.alloc(batchSize);
+      let offset = 0;
+      data[offset++] = MessageType.Batch;
+      for (const msg of batch) {
+        data.writeUInt16LE(msg.length, offset);
+        offset += 2;
+        msg.copy(data, offset);
+        offset += msg.length;
+      }
+      writeFrame(socket, data);
+    }
+    batch = [];
+    batchSize = 1;
+  };
+
+  for (const msg of messages) {
+    // 放不进批量包的大消息单独发送
+    if (1 + 2 + msg.length > MAX_FRAME_SIZE) {
+      finishBatch();
+      writeFrame(socket, msg);
+      continue;
+    }
+    if (batchSize + 2 + msg.length > MAX_FRAME_SIZE) {
+      finishBatch();
+    }
+    batch.push(msg);
+    batchSize += 2 + msg.length;
+  }
+  finishBatch();
+}
+
+// 发送消息给客户端（在本轮事件循环结束时合并写出）
+function sendMessage(socket, data) {
+  if (!socket.outbox) {
+    socket.outbox = [];
+    setImmediate(flushOutbox, socket);
+  }
+  socket.outbox.push(data);
+}
+
 // 广播给房间内其他玩家
 function broadcastToRoom(room, senderSocket, data) {
   for (const player of room.players) {
@@ -114,15 +196,40 @@ function handleMessage(socket, data) {
   const msgType = data[0];
 
   switch (msgType) {
+    case MessageType.Batch: {
+      // 逐条拆出批量包中的消息
+      let offset = 1;
+      while (offset + 2 <= data.length) {
+        const len = data.readUInt16LE(offset);
+        offset += 2;
+        if (offset + len > data.length) break;
+        handleMessage(socket, data.subarray(offset, offset + len));
+        offset += len;
+      }
+      break;
+    }
+
     case MessageType.Connect: {
       console.log('Client connected');
-      // 发送连接确认
-      const response = Buffer.alloc(1);
+      // 分配 UDP 会话ID
+      if (!socket.sessionId) {
+        socket.sessionId = createSessionId();
+        sessions.set(socket.sessionId, socket);
+      }
+      // 发送连接确认（附带会话ID）
+      const response = Buffer.alloc(5);
       response[0] = MessageType.ConnectAck;
+      response.writeUInt32LE(socket.sessionId, 1);
       sendMessage(socket, response);
       break;
     }
 
+    case MessageType.UdpReady: {
+      // 之后向该玩家转发状态消息时使用 UDP
+      socket.udpConfirmed = true;
+      break;
+    }
+
     case MessageType.Disconnect: {
       console.log('Client requested disconnect');
       // 触发清理逻辑（与close事件相同）
@@ -172,8 +279,9 @@ function handleMessage(socket, data) {
       break;
     }
 
-    case MessageType.MazeData: {
-      // 房主发送迷宫数据
+    case MessageType.MazeData:
+    case MessageType.MazeSeed: {
+      // 房主发送迷宫数据（完整数据或种子）
       const roomCode = socket.roomCode;
       if (!roomCode) break;
 
@@ -202,6 +310,22 @@ function handleMessage(socket, data) {
       break;
     }
 
+    case MessageType.RequestMaze: {
+      // 非房主用种子生成的迷宫校验失败，请求房主发送完整迷宫数据
+      const roomCode = socket.roomCode;
+      if (!roomCode || socket.isHost) break;
+
+      const room = rooms.get(roomCode);
+      if (!room) break;
+
+      const host = room.players.find(p => p.isHost);
+      if (host) {
+        sendMessage(host.socket, data);
+        console.log(`Guest requested full maze data in room ${roomCode}`);
+      }
+      break;
+    }
+
     case MessageType.JoinRoom: {
       const codeLen = data[1];
       const roomCode = data.slice(2, 2 + codeLen).toString();
@@ -445,6 +569,10 @@ function handleMessage(socket, data) {
     // NPC同步消息 - 直接转发给房间内其他玩家
     case MessageType.NpcActivate:
     case MessageType.NpcUpdate:
+    case MessageType.NpcSnapshot:
+    case MessageType.NpcSnapshotAck:
+    case MessageType.PlayerInput:
+    case MessageType.PlayerCorrection:
     case MessageType.NpcShoot:
     case MessageType.NpcDamage:
     case MessageType.ClimaxStart:
@@ -475,6 +603,10 @@ const server = net.createServer((socket) => {
     if (isCleanedUp) return;
     isCleanedUp = true;
 
+    if (socket.sessionId) {
+      sessions.delete(socket.sessionId);
+    }
+
     console.log('Cleaning up player...');
 
     if (socket.roomCode) {
@@ -555,7 +687,52 @@ const server = net.createServer((socket) => {
   });
 });
 
+// UDP 转发：状态消息（位置、NPC状态等）按会话ID找到房间，原样转发给房间内其他玩家
+// 序号由客户端检查，过期的数据报在接收端丢弃
+const udpServer = dgram.createSocket('udp4');
+
+udpServer.on('message', (msg, rinfo) => {
+  if (msg.length < UDP_HEADER_SIZE) return;
+
+  const socket = sessions.get(msg.readUInt32LE(0));
+  if (!socket) return;
+
+  // 记录（或更新）发送方的 UDP 地址，只有包头的数据报仅用于登记：原样回显，客户端收到后才启用 UDP
+  socket.udpAddress = rinfo.address;
+  socket.udpPort = rinfo.port;
+  if (msg.length === UDP_HEADER_SIZE) {
+    udpServer.send(msg, rinfo.port, rinfo.address);
+    return;
+  }
+
+  const room = rooms.get(socket.roomCode);
+  if (!room || !room.started) return;
+
+  for (const player of room.players) {
+    const target = player.socket;
+    if (target === socket) continue;
+    if (target.udpConfirmed) {
+      udpServer.send(msg, target.udpPort, target.udpAddress);
+    } else {
+      // 对方的 UDP 不可用：拆出 [长度(2) + 消息] 条目改走 TCP
+      let offset = UDP_HEADER_SIZE;
+      while (offset + 2 <= msg.length) {
+        const len = msg.readUInt16LE(offset);
+        offset += 2;
+        if (offset + len > msg.length) break;
+        sendMessage(target, Buffer.from(msg.subarray(offset, offset + len)));
+        offset += len;
+      }
+    }
+  }
+});
+
+udpServer.on('error', (err) => {
+  console.error('UDP error:', err.message);
+});
+
 const PORT = 9999;
+udpServer.bind(PORT);
 server.listen(PORT, () => {
   console.log(`Tank Maze Server running on port ${PORT}`);
   console.log('Waiting for players...');
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <random>
 
 Game::Game()
     : m_mazeGenerator(31, 21) // 默认中等尺寸
@@ -108,31 +109,101 @@ bool Game::init()
   return true;
 }
 
+MazeRecipe Game::singlePlayerMazeSettings() const
+{
+  MazeRecipe settings;
+  settings.width = m_mazeWidth;
+  settings.height = m_mazeHeight;
+  settings.enemyCount = m_enemyOptions[m_enemyIndex];
+  settings.multiplayerMode = false;
+  settings.escapeMode = (m_gameModeOption == GameModeOption::EscapeMode); // 单人 Escape 也生成治疗墙
+  return settings;
+}
+
+MazeRecipe Game::multiplayerMazeSettings(int width, int height, int npcCount) const
+{
+  // 联机模式生成特殊方块，根据游戏模式决定墙体类型
+  MazeRecipe settings;
+  settings.width = width;
+  settings.height = height;
+  settings.enemyCount = npcCount;
+  settings.multiplayerMode = true;
+  settings.escapeMode = m_mpState.isEscapeMode;
+  return settings;
+}
+
 void Game::generateRandomMaze()
 {
+  // 优先换入后台预生成好的迷宫（已解析并烘焙），重新开始不卡顿
+  MazeRecipe settings = singlePlayerMazeSettings();
+  if (auto prepared = m_mazePool.tryTake(settings))
+  {
+    m_maze = std::move(prepared->maze);
+    return;
+  }
+
   // 使用已设置的迷宫尺寸（来自预设或自定义）
   m_mazeGenerator = MazeGenerator(m_mazeWidth, m_mazeHeight);
 
   // 使用菜单中选择的敌人数量
-  int enemyCount = m_enemyOptions[m_enemyIndex];
-  m_mazeGenerator.setEnemyCount(enemyCount);
+  m_mazeGenerator.setEnemyCount(settings.enemyCount);
   m_mazeGenerator.setDestructibleRatio(0.15f);
 
   // 设置 Escape 模式（单人 Escape 也生成治疗墙）
-  bool isEscape = (m_gameModeOption == GameModeOption::EscapeMode);
-  m_mazeGenerator.setEscapeMode(isEscape);
+  m_mazeGenerator.setEscapeMode(settings.escapeMode);
 
   auto mazeMap = m_mazeGenerator.generate();
   m_maze.loadFromString(mazeMap);
 }
 
-void Game::startGame()
+void Game::generateMultiplayerMaze(int width, int height, int npcCount)
+{
+  MazeRecipe recipe = multiplayerMazeSettings(width, height, npcCount);
+  std::uint32_t checksum = 0;
+
+  if (auto prepared = m_mazePool.tryTake(recipe))
+  {
+    // 换入预生成好的迷宫，沿用它的种子和校验和
+    m_maze = std::move(prepared->maze);
+    recipe = prepared->recipe;
+    checksum = prepared->checksum;
+  }
+  else
+  {
+    recipe.seed = std::random_device{}();
+    if (recipe.seed == 0)
+      recipe.seed = 1; // 0 表示不指定种子
+
+    const std::vector<std::string> mazeData = MazeGenerator::generateFromRecipe(recipe);
+    m_maze.loadFromString(mazeData);
+    checksum = MazeGenerator::checksum(mazeData);
+  }
+  m_mpState.packedMaze = m_maze.getPackedData();
+
+  // 状态编码的位置范围按实际生成的尺寸（生成器会把偶数尺寸补成奇数），与对方解析出的一致
+  MazeCodec::Header header;
+  if (MazeCodec::readHeader(m_mpState.packedMaze, header))
+  {
+    NetworkManager::getInstance().setMazeSize(header.rows, header.cols);
+  }
+
+  // 只发送种子和参数，对方生成后用校验和确认（不一致时会请求完整数据）
+  NetworkManager::getInstance().sendMazeSeed(recipe, checksum, m_mpState.isDarkMode);
+}
+
+void Game::startGame(bool useSavedMaze)
 {
   // 停止所有残留音效
   AudioManager::getInstance().stopAllSFX();
 
-  // 生成随机地图
-  generateRandomMaze();
+  // 读取存档的迷宫，没有存档或存档损坏时生成随机地图
+  m_mazeSaveStatus.clear();
+  if (!useSavedMaze || !m_maze.loadFromFile(getResourcePath() + SAVED_MAZE_FILE))
+  {
+    if (useSavedMaze)
+      m_mazeSaveStatus = "No valid saved maze, generated a new one";
+    generateRandomMaze();
+  }
 
   // 创建玩家
   m_player = std::make_unique<Tank>();
@@ -205,7 +276,7 @@ void Game::resetGame()
   m_mpState.connectionStatus = "Enter server IP:";
   m_inputText.clear();
   m_inputMode = InputMode::None;
-  m_mpState.generatedMazeData.clear();
+  m_mpState.packedMaze.clear();
 
   // 重置 Escape 模式相关状态
   m_mpState.isEscapeMode = false;
@@ -259,6 +330,8 @@ void Game::run()
       {
         AudioManager::getInstance().playBGM(BGMType::Menu);
       }
+      // 按当前菜单设置在后台预生成迷宫
+      m_mazePool.configure(singlePlayerMazeSettings());
       break;
     case GameState::Playing:
       update(dt);
@@ -281,6 +354,11 @@ void Game::run()
       {
         AudioManager::getInstance().playBGM(BGMType::Menu);
       }
+      // 房主在大厅时按房间设置预生成迷宫
+      if (m_gameState == GameState::RoomLobby && m_mpState.isHost)
+      {
+        m_mazePool.configure(multiplayerMazeSettings(m_mpState.mazeWidth, m_mpState.mazeHeight, m_mpState.npcCount));
+      }
       break;
     case GameState::Multiplayer:
       updateMultiplayer(dt);
@@ -299,6 +377,9 @@ void Game::run()
       break;
     }
 
+    // 本帧产生的网络消息合并成一次写入
+    NetworkManager::getInstance().flush();
+
     render();
   }
 
@@ -750,9 +831,7 @@ void Game::processEvents()
 
               // 重新生成迷宫（使用菜单选择的NPC数量，联机模式，根据游戏模式决定墙体类型）
               int npcCount = m_enemyOptions[m_enemyIndex];
-              m_maze.generateRandomMaze(m_mazeWidth, m_mazeHeight, 0, npcCount, true, m_mpState.isEscapeMode);
-              m_mpState.generatedMazeData = m_maze.getMazeData();
-              NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode);
+              generateMultiplayerMaze(m_mazeWidth, m_mazeHeight, npcCount);
 
               // 房主默认准备
               m_mpState.localPlayerReady = true;
@@ -787,6 +866,15 @@ void Game::processEvents()
             startGame(); // 单机模式重新开始
           }
         }
+        else if (keyPressed->code == sf::Keyboard::Key::S && !m_mpState.isMultiplayer)
+        {
+          // 保存刚玩过的迷宫（压缩数据是开局时的布局，不含游戏中的破坏）
+          m_mazeSaveStatus = m_maze.saveToFile(getResourcePath() + SAVED_MAZE_FILE) ? "Maze saved" : "Failed to save maze";
+        }
+        else if (keyPressed->code == sf::Keyboard::Key::L && !m_mpState.isMultiplayer)
+        {
+          startGame(true); // 重玩存档的迷宫
+        }
         else if (keyPressed->code == sf::Keyboard::Key::Escape)
         {
           resetGame(); // 返回菜单
@@ -1099,8 +1187,8 @@ void Game::update(float dt)
     }
   }
 
-  // 更新迷宫
-  m_maze.update(dt);
+  // 更新迷宫（只处理镜头附近的格子）
+  m_maze.update(dt, m_gameView);
 
   // 更新子弹
   for (auto &bullet : m_bullets)
@@ -1815,7 +1903,7 @@ void Game::renderGameOver()
   }
   else
   {
-    hint.setString("Press R to restart, ESC for menu");
+    hint.setString("Press R to restart, S to save maze, L to replay saved maze, ESC for menu");
   }
 
   hint.setCharacterSize(28);
@@ -1823,6 +1911,18 @@ void Game::renderGameOver()
   sf::FloatRect hintBounds = hint.getLocalBounds();
   hint.setPosition({(LOGICAL_WIDTH - hintBounds.size.x) / 2.f, LOGICAL_HEIGHT / 2.f + 20.f});
   m_window.draw(hint);
+
+  // 存档/读档结果
+  if (!m_mpState.isMultiplayer && !m_mazeSaveStatus.empty())
+  {
+    sf::Text status(m_font);
+    status.setString(m_mazeSaveStatus);
+    status.setCharacterSize(24);
+    status.setFillColor(sf::Color(200, 200, 200));
+    sf::FloatRect statusBounds = status.getLocalBounds();
+    status.setPosition({(LOGICAL_WIDTH - statusBounds.size.x) / 2.f, LOGICAL_HEIGHT / 2.f + 70.f});
+    m_window.draw(status);
+  }
 }
 
 void Game::setupNetworkCallbacks()
@@ -1857,6 +1957,11 @@ void Game::setupNetworkCallbacks()
     m_otherPlayer.reset();
     m_enemies.clear();
     m_bullets.clear();
+    m_mpState.remoteClock.reset();
+    m_mpState.otherPlayerSnapshots.clear();
+    m_mpState.npcSnapshots.clear();
+    m_mpState.inputHistory.clear();
+    m_mpState.guestAuthority.clear();
     
     // 重置多人游戏状态
     m_mpState.localPlayerReachedExit = false;
@@ -1881,18 +1986,13 @@ void Game::setupNetworkCallbacks()
       
       // 保留当前的游戏设置（尺寸、NPC数量、模式）
       // 新地图会在开始游戏时生成
-      if (!m_mpState.generatedMazeData.empty()) {
-        m_mpState.mazeHeight = static_cast<int>(m_mpState.generatedMazeData.size());
-        m_mpState.mazeWidth = static_cast<int>(m_mpState.generatedMazeData[0].size());
+      MazeCodec::Header header;
+      if (MazeCodec::readHeader(m_mpState.packedMaze, header)) {
+        m_mpState.mazeHeight = header.rows;
+        m_mpState.mazeWidth = header.cols;
         
         // 重新计算NPC数量
-        int npcCount = 0;
-        for (const auto& row : m_mpState.generatedMazeData) {
-          for (char c : row) {
-            if (c == 'X') npcCount++;
-          }
-        }
-        m_mpState.npcCount = npcCount;
+        m_mpState.npcCount = MazeCodec::countTiles(m_mpState.packedMaze, MazeCodec::Tile::Enemy);
       }
       
       std::cout << "[DEBUG] Became host. Settings: " << m_mpState.mazeWidth << "x" << m_mpState.mazeHeight 
@@ -1929,20 +2029,12 @@ void Game::setupNetworkCallbacks()
     // 房主生成迷宫（使用菜单选择的NPC数量，联机模式生成特殊方块，根据游戏模式决定墙体类型）
     int npcCount = m_enemyOptions[m_enemyIndex];
     std::cout << "[DEBUG] Creating room with " << npcCount << " NPCs, isEscapeMode=" << m_mpState.isEscapeMode << std::endl;
-    m_maze.generateRandomMaze(m_mazeWidth, m_mazeHeight, 0, npcCount, true, m_mpState.isEscapeMode);
-    m_mpState.generatedMazeData = m_maze.getMazeData();
+    generateMultiplayerMaze(m_mazeWidth, m_mazeHeight, npcCount);
     
     // 检查迷宫数据中是否有敌人标记 'X'
-    int xCount = 0;
-    for (const auto& row : m_mpState.generatedMazeData) {
-      for (char c : row) {
-        if (c == 'X') xCount++;
-      }
-    }
+    int xCount = MazeCodec::countTiles(m_mpState.packedMaze, MazeCodec::Tile::Enemy);
     std::cout << "[DEBUG] Maze data contains " << xCount << " enemy markers (X)" << std::endl;
     
-    NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode);
-    
     // 进入房间大厅
     m_gameState = GameState::RoomLobby;
     m_mpState.connectionStatus = "Room created! Code: " + roomCode; });
@@ -1959,25 +2051,20 @@ void Game::setupNetworkCallbacks()
     m_gameState = GameState::RoomLobby;
     m_mpState.connectionStatus = "Joined room: " + roomCode; });
 
-  net.setOnMazeData([this](const std::vector<std::string> &mazeData, bool isDarkMode)
+  net.setOnMazeData([this](std::span<const uint8_t> packedMaze, bool isDarkMode)
                     {
-    // 收到迷宫数据（非房主）
-    m_mpState.generatedMazeData = mazeData;
+    // 收到迷宫数据（非房主），保持压缩格式，开局时直接解码到迷宫
+    m_mpState.packedMaze.assign(packedMaze.begin(), packedMaze.end());
     m_mpState.isDarkMode = isDarkMode;
     
     // 解析迷宫尺寸
-    if (!mazeData.empty()) {
-      m_mpState.mazeHeight = static_cast<int>(mazeData.size());
-      m_mpState.mazeWidth = static_cast<int>(mazeData[0].size());
+    MazeCodec::Header header;
+    if (MazeCodec::readHeader(packedMaze, header)) {
+      m_mpState.mazeHeight = header.rows;
+      m_mpState.mazeWidth = header.cols;
       
       // 计算NPC数量
-      int npcCount = 0;
-      for (const auto& row : mazeData) {
-        for (char c : row) {
-          if (c == 'X') npcCount++;
-        }
-      }
-      m_mpState.npcCount = npcCount;
+      m_mpState.npcCount = MazeCodec::countTiles(packedMaze, MazeCodec::Tile::Enemy);
     }
     
     m_mpState.connectionStatus = "Maze received!"; });
@@ -1991,8 +2078,8 @@ void Game::setupNetworkCallbacks()
   net.setOnRequestMaze([this]()
                        {
     // 服务器请求迷宫数据（房主收到）
-    if (m_mpState.isHost && !m_mpState.generatedMazeData.empty()) {
-      NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode);
+    if (m_mpState.isHost && !m_mpState.packedMaze.empty()) {
+      NetworkManager::getInstance().sendMazeData(m_mpState.packedMaze, m_mpState.isEscapeMode, m_mpState.isDarkMode);
     } });
 
   net.setOnGameStart([this]()
@@ -2000,8 +2087,8 @@ void Game::setupNetworkCallbacks()
     m_mpState.isMultiplayer = true;
     
     // 使用已接收/生成的迷宫数据
-    if (!m_mpState.generatedMazeData.empty()) {
-      m_maze.loadFromString(m_mpState.generatedMazeData);
+    if (!m_mpState.packedMaze.empty()) {
+      m_maze.loadFromPacked(m_mpState.packedMaze);
     }
     
     // 获取两个出生点位置（从迷宫数据中解析的 '1' 和 '2' 标记）
@@ -2056,6 +2143,19 @@ void Game::setupNetworkCallbacks()
     m_otherPlayer->setPosition(otherSpawn);
     m_otherPlayer->setScale(m_tankScale);
     
+    // 新的一局：清空远端快照
+    m_mpState.remoteClock.reset();
+    m_mpState.otherPlayerSnapshots.clear();
+    m_mpState.npcSnapshots.clear();
+    
+    // 客户端预测：房主从对方出生点开始按其输入模拟
+    m_mpState.inputHistory.clear();
+    if (m_mpState.isHost) {
+      m_mpState.guestAuthority.reset(otherSpawn, m_tankScale);
+    } else {
+      m_mpState.guestAuthority.clear();
+    }
+    
     // 设置阵营：Escape 模式下双方同队，Battle 模式下对立
     if (m_mpState.isEscapeMode) {
       // Escape 模式：双方都是队伍1，队友之间不会伤害
@@ -2113,9 +2213,14 @@ void Game::setupNetworkCallbacks()
   net.setOnPlayerUpdate([this](const PlayerState &state)
                         {
     if (m_otherPlayer) {
-      m_otherPlayer->setPosition({state.x, state.y});
-      m_otherPlayer->setRotation(state.rotation);
-      m_otherPlayer->setTurretRotation(state.turretAngle);
+      // 位置和角度先进入插值缓冲区，由 MultiplayerHandler 每帧按固定延迟设置
+      auto &net = NetworkManager::getInstance();
+      EntitySnapshot snapshot;
+      snapshot.time = m_mpState.remoteClock.observe(state.tick, net.getTickInterval(), net.getReceiveTime());
+      snapshot.position = {state.x, state.y};
+      snapshot.rotation = state.rotation;
+      snapshot.turretAngle = state.turretAngle;
+      m_mpState.otherPlayerSnapshots.push(snapshot);
       m_otherPlayer->setHealth(state.health);
       m_mpState.otherPlayerReachedExit = state.reachedExit;
       
@@ -2138,6 +2243,23 @@ void Game::setupNetworkCallbacks()
       }
     } });
 
+  net.setOnPlayerInput([this](std::span<const InputCommand> inputs)
+                       {
+    // 房主：按对方的输入模拟其坦克，节拍边界时发回权威位置
+    if (m_mpState.isHost) {
+      m_mpState.guestAuthority.apply(inputs, m_maze);
+    } });
+
+  net.setOnPlayerCorrection([this](uint32_t lastInput, sf::Vector2f position, float rotation)
+                            {
+    // 非房主：从房主的权威位置出发，重新执行房主尚未处理的输入
+    if (!m_mpState.isHost && m_player && !m_mpState.localPlayerDead &&
+        m_mpState.inputHistory.acknowledge(lastInput)) {
+      m_player->setPosition(position);
+      m_player->setRotation(rotation);
+      m_mpState.inputHistory.replay(*m_player, m_maze);
+    } });
+
   net.setOnPlayerShoot([this](float x, float y, float angle)
                        {
     // 创建另一个玩家的子弹 - 紫色
@@ -2209,7 +2331,7 @@ void Game::setupNetworkCallbacks()
 
   net.setOnNpcUpdate([this](const NpcState &state)
                      {
-    // 更新NPC状态（仅非房主接收）- 直接设置位置，不使用插值
+    // 更新NPC状态（仅非房主接收）
     if (!m_mpState.isHost && state.id >= 0 && state.id < static_cast<int>(m_enemies.size())) {
       auto& npc = m_enemies[state.id];
       
@@ -2218,10 +2340,17 @@ void Game::setupNetworkCallbacks()
         return;
       }
       
-      // 直接设置NPC位置、旋转、炮塔角度
-      npc->setPosition({state.x, state.y});
-      npc->setRotation(state.rotation);
-      npc->setTurretRotation(state.turretAngle);
+      // 位置、旋转、炮塔角度进入插值缓冲区，由 MultiplayerHandler 每帧按固定延迟设置
+      auto &net = NetworkManager::getInstance();
+      EntitySnapshot snapshot;
+      snapshot.time = m_mpState.remoteClock.observe(state.tick, net.getTickInterval(), net.getReceiveTime());
+      snapshot.position = {state.x, state.y};
+      snapshot.rotation = state.rotation;
+      snapshot.turretAngle = state.turretAngle;
+      if (m_mpState.npcSnapshots.size() < m_enemies.size()) {
+        m_mpState.npcSnapshots.resize(m_enemies.size());
+      }
+      m_mpState.npcSnapshots[state.id].push(snapshot);
       
       // 更新血量（只有当远程血量更低时才更新）
       if (state.health < npc->getHealth()) {
@@ -2562,12 +2691,8 @@ void Game::processRoomLobbyEvents(const sf::Event &event)
         // 设置迷宫生成器模式
         m_mazeGenerator.setEscapeMode(m_mpState.isEscapeMode);
 
-        // 生成新地图
-        m_maze.generateRandomMaze(m_mpState.mazeWidth, m_mpState.mazeHeight, 0, npcCount, true, m_mpState.isEscapeMode);
-        m_mpState.generatedMazeData = m_maze.getMazeData();
-
-        // 发送新地图给服务器和对方玩家
-        NetworkManager::getInstance().sendMazeData(m_mpState.generatedMazeData, m_mpState.isEscapeMode, m_mpState.isDarkMode);
+        // 生成新地图，并把种子发送给服务器和对方玩家
+        generateMultiplayerMaze(m_mpState.mazeWidth, m_mpState.mazeHeight, npcCount);
 
         std::cout << "[DEBUG] Host generated new maze before game start: "
                   << m_mpState.mazeWidth << "x" << m_mpState.mazeHeight
@@ -2815,6 +2940,11 @@ void Game::processCreatingRoomEvents(const sf::Event &event)
       m_darkModeOption = !m_darkModeOption;
       AudioManager::getInstance().playSFXGlobal(SFXType::MenuSelect);
       break;
+    case sf::Keyboard::Key::T:
+      // 切换网络节拍频率
+      m_tickRateIndex = (m_tickRateIndex + 1) % static_cast<int>(m_tickRateOptions.size());
+      AudioManager::getInstance().playSFXGlobal(SFXType::MenuSelect);
+      break;
     case sf::Keyboard::Key::Escape:
       // 返回连接界面
       AudioManager::getInstance().playSFXGlobal(SFXType::MenuSelect);
@@ -2826,6 +2956,7 @@ void Game::processCreatingRoomEvents(const sf::Event &event)
       AudioManager::getInstance().playSFXGlobal(SFXType::MenuConfirm);
       m_mpState.isEscapeMode = (m_gameModeOption == GameModeOption::EscapeMode);
       m_mpState.isDarkMode = m_darkModeOption;
+      NetworkManager::getInstance().setTickRate(m_tickRateOptions[m_tickRateIndex]);
       NetworkManager::getInstance().createRoom(m_mazeWidth, m_mazeHeight, m_darkModeOption);
       break;
     default:
@@ -2946,6 +3077,17 @@ void Game::renderCreatingRoom()
     m_window.draw(desc);
   }
 
+  // 网络节拍频率选项
+  {
+    sf::Text tickRateText(m_font);
+    tickRateText.setString("Tick Rate: " + std::to_string(m_tickRateOptions[m_tickRateIndex]) + " Hz (T to change)");
+    tickRateText.setCharacterSize(24);
+    tickRateText.setFillColor(sf::Color(150, 150, 150));
+    sf::FloatRect bounds = tickRateText.getLocalBounds();
+    tickRateText.setPosition({centerX - bounds.size.x / 2.f, startY + spacing * 2 + 95.f});
+    m_window.draw(tickRateText);
+  }
+
   // 地图信息
   sf::Text mapInfo(m_font);
   mapInfo.setString("Map: " + std::to_string(m_mazeWidth) + " x " + std::to_string(m_mazeHeight) +
@@ -2953,12 +3095,12 @@ void Game::renderCreatingRoom()
   mapInfo.setCharacterSize(24);
   mapInfo.setFillColor(sf::Color(100, 200, 100));
   sf::FloatRect mapBounds = mapInfo.getLocalBounds();
-  mapInfo.setPosition({centerX - mapBounds.size.x / 2.f, 560.f});
+  mapInfo.setPosition({centerX - mapBounds.size.x / 2.f, 600.f});
   m_window.draw(mapInfo);
 
   // 提示
   sf::Text hint(m_font);
-  hint.setString("W/S: Game Mode | D: Dark Mode | Enter: Create Room | ESC: Back");
+  hint.setString("W/S: Game Mode | D: Dark Mode | T: Tick Rate | Enter: Create Room | ESC: Back");
   hint.setCharacterSize(18);
   hint.setFillColor(sf::Color(120, 120, 120));
   sf::FloatRect hintBounds = hint.getLocalBounds();
@@ -1,5 +1,6 @@
 #include "Enemy.hpp"
 #include "Maze.hpp"
+#include "TextureCache.hpp"
 #include "Utils.hpp"
 #include <cstdlib>
 #include <cmath>
@@ -18,18 +19,24 @@ Enemy::Enemy()
 
 bool Enemy::loadTextures(const std::string &hullPath, const std::string &turretPath)
 {
-  if (!m_hullTexture.loadFromFile(hullPath))
-    return false;
-  if (!m_turretTexture.loadFromFile(turretPath))
+  TextureCache &cache = TextureCache::getInstance();
+  m_hullTexture = cache.acquire(hullPath);
+  m_turretTexture = cache.acquire(turretPath);
+  if (!m_hullTexture || !m_turretTexture)
     return false;
 
-  m_hull = std::make_unique<sf::Sprite>(m_hullTexture);
-  m_hull->setOrigin(sf::Vector2f(m_hullTexture.getSize()) / 2.f);
+  // 激活状态贴图（Color_C）在这里一起获取，激活时只需切换纹理，不再读磁盘
+  std::string resPath = getResourcePath();
+  m_activatedHullTexture = cache.acquire(resPath + "tank_assets/PNG/Hulls_Color_C/Hull_01.png");
+  m_activatedTurretTexture = cache.acquire(resPath + "tank_assets/PNG/Weapon_Color_C/Gun_01.png");
+
+  m_hull = std::make_unique<sf::Sprite>(*m_hullTexture);
+  m_hull->setOrigin(sf::Vector2f(m_hullTexture->getSize()) / 2.f);
   m_hull->setScale({m_scale, m_scale});
 
-  m_turret = std::make_unique<sf::Sprite>(m_turretTexture);
+  m_turret = std::make_unique<sf::Sprite>(*m_turretTexture);
   // 炮塔旋转中心在底部中心（炮塔底座位置）
-  auto turretSize1 = sf::Vector2f(m_turretTexture.getSize());
+  auto turretSize1 = sf::Vector2f(m_turretTexture->getSize());
   m_turret->setOrigin({turretSize1.x / 2.f, turretSize1.y * 0.75f});
   m_turret->setScale({m_scale, m_scale});
 
@@ -38,32 +45,20 @@ bool Enemy::loadTextures(const std::string &hullPath, const std::string &turretP
 
 bool Enemy::loadActivatedTextures()
 {
-  // 加载激活状态的贴图（Color_C）
-  std::string resPath = getResourcePath();
-  if (!m_hullTexture.loadFromFile(resPath + "tank_assets/PNG/Hulls_Color_C/Hull_01.png"))
-    return false;
-  if (!m_turretTexture.loadFromFile(resPath + "tank_assets/PNG/Weapon_Color_C/Gun_01.png"))
+  if (!m_activatedHullTexture || !m_activatedTurretTexture || !m_hull || !m_turret)
     return false;
 
-  // 保存当前位置和旋转
-  sf::Vector2f pos = m_hull ? m_hull->getPosition() : sf::Vector2f{0.f, 0.f};
-  float hullRot = m_hull ? m_hull->getRotation().asDegrees() : 0.f;
-  float turretRot = m_turret ? m_turret->getRotation().asDegrees() : 0.f;
+  // 只切换纹理指针，位置/旋转/缩放保持不变
+  m_hullTexture = m_activatedHullTexture;
+  m_turretTexture = m_activatedTurretTexture;
 
-  // 重新创建精灵
-  m_hull = std::make_unique<sf::Sprite>(m_hullTexture);
-  m_hull->setOrigin(sf::Vector2f(m_hullTexture.getSize()) / 2.f);
-  m_hull->setScale({m_scale, m_scale});
-  m_hull->setPosition(pos);
-  m_hull->setRotation(sf::degrees(hullRot));
+  m_hull->setTexture(*m_hullTexture, true);
+  m_hull->setOrigin(sf::Vector2f(m_hullTexture->getSize()) / 2.f);
 
-  m_turret = std::make_unique<sf::Sprite>(m_turretTexture);
+  m_turret->setTexture(*m_turretTexture, true);
   // 炮塔旋转中心在底部中心（炮塔底座位置）
-  auto turretSize2 = sf::Vector2f(m_turretTexture.getSize());
+  auto turretSize2 = sf::Vector2f(m_turretTexture->getSize());
   m_turret->setOrigin({turretSize2.x / 2.f, turretSize2.y * 0.75f});
-  m_turret->setScale({m_scale, m_scale});
-  m_turret->setPosition(pos);
-  m_turret->setRotation(sf::degrees(turretRot));
 
   return true;
 }
@@ -125,81 +120,94 @@ void Enemy::update(float dt, const Maze &maze)
   // 保存旧位置
   sf::Vector2f oldPos = m_hull->getPosition();
 
+  // 规划时取得的流场被迷宫改给其他目标、或地图已变化：提前重新规划
+  if (m_flowField && (m_flowField->getGoal() != m_flowGoal ||
+                      m_flowField->getDestructibleCost() != m_destructibleWallCost ||
+                      maze.getTileVersion() != m_flowTileVersion))
+  {
+    m_flowField.reset();
+  }
+
   // 定期更新路径（使用智能路径，考虑可破坏墙）
-  if (m_pathUpdateClock.getElapsedTime().asSeconds() > m_pathUpdateInterval || m_path.empty())
+  // 流场由迷宫按目标格子共享，这里只查询自己所在格子；到达目标格子或不可达时等到下次定期规划
+  if (m_pathUpdateClock.getElapsedTime().asSeconds() > m_pathUpdateInterval || !m_flowField)
   {
-    // 首先尝试普通路径
-    auto normalPath = maze.findPath(oldPos, m_targetPos);
+    int cell = maze.gridToIndex(maze.worldToGrid(oldPos));
+
+    // 同一个流场里同时有普通路径（可破坏墙不可通行）和智能路径（可破坏墙视为高代价）
+    m_flowField = maze.getFlowField(m_targetPos, m_destructibleWallCost);
+    m_flowGoal = m_flowField->getGoal();
+    m_flowTileVersion = maze.getTileVersion();
+    const FlowField &field = *m_flowField;
 
-    // 然后尝试穿过可破坏墙的路径
-    auto smartPathResult = maze.findPathThroughDestructible(oldPos, m_targetPos, 10.0f);
+    // 路径长度（格子数），0 表示没有路径
+    int normalLen = field.isReachable(cell, FlowLabel::Open) ? field.getSteps(cell, FlowLabel::Open) : 0;
+    int smartLen = field.isReachable(cell, FlowLabel::Breach) ? field.getSteps(cell, FlowLabel::Breach) : 0;
+    int firstBreach = smartLen > 0 ? field.getFirstBreach(cell) : -1;
 
     // 比较两条路径，选择更优的
     // 如果智能路径明显更短（考虑到可破坏墙的额外代价），则使用智能路径
     bool useSmartPath = false;
 
-    if (!smartPathResult.path.empty())
+    if (smartLen > 0)
     {
-      if (normalPath.empty())
+      if (normalLen == 0)
       {
         // 普通路径找不到，使用智能路径
         useSmartPath = true;
       }
-      else if (smartPathResult.hasDestructibleWall)
+      else if (firstBreach >= 0)
       {
         // 如果智能路径穿过可破坏墙，比较实际长度
         // 智能路径需要比普通路径短很多才值得（因为需要花时间打墙）
-        float normalLen = static_cast<float>(normalPath.size());
-        float smartLen = static_cast<float>(smartPathResult.path.size());
-
         // 如果智能路径比普通路径短50%以上，使用智能路径
         if (smartLen < normalLen * 0.5f)
         {
           useSmartPath = true;
         }
       }
-      else
-      {
-        // 智能路径没有可破坏墙，且不为空，说明和普通路径一样
-        useSmartPath = false;
-      }
+      // 智能路径没有可破坏墙，说明和普通路径一样
     }
 
+    m_followBreachField = useSmartPath;
     if (useSmartPath)
     {
-      m_path = smartPathResult.path;
-      m_hasDestructibleWallOnPath = smartPathResult.hasDestructibleWall;
-      m_destructibleWallTarget = smartPathResult.firstDestructibleWallPos;
+      m_flowWaypoint = field.getNextTile(cell, FlowLabel::Breach);
+      m_hasDestructibleWallOnPath = firstBreach >= 0;
+      m_destructibleWallTarget = firstBreach >= 0 ? maze.gridToWorld(maze.indexToGrid(firstBreach)) : sf::Vector2f{0.f, 0.f};
     }
     else
     {
-      m_path = normalPath;
+      m_flowWaypoint = normalLen > 0 ? field.getNextTile(cell, FlowLabel::Open) : -1;
       m_hasDestructibleWallOnPath = false;
       m_destructibleWallTarget = {0.f, 0.f};
     }
 
-    m_currentPathIndex = 0;
     m_pathUpdateClock.restart();
   }
 
   // 沿路径移动
   sf::Vector2f moveTarget = m_targetPos; // 默认直接朝向玩家
 
-  if (!m_path.empty() && m_currentPathIndex < m_path.size())
+  if (m_flowWaypoint >= 0)
   {
-    moveTarget = m_path[m_currentPathIndex];
+    moveTarget = maze.gridToWorld(maze.indexToGrid(m_flowWaypoint));
 
     // 检查是否接近当前路径点
     sf::Vector2f toWaypoint = moveTarget - oldPos;
     float distToWaypoint = std::sqrt(toWaypoint.x * toWaypoint.x + toWaypoint.y * toWaypoint.y);
 
-    if (distToWaypoint < 20.f)
+    if (distToWaypoint < 20.f && m_flowField)
     {
-      // 移动到下一个路径点
-      m_currentPathIndex++;
-      if (m_currentPathIndex < m_path.size())
+      // 沿规划时的流场移动到下一个路径点（到达目标格子后为 -1，改为直接朝向玩家）
+      m_flowWaypoint = m_flowField->getNextTile(m_flowWaypoint, m_followBreachField ? FlowLabel::Breach : FlowLabel::Open);
+      if (m_flowWaypoint >= 0)
+      {
+        moveTarget = maze.gridToWorld(maze.indexToGrid(m_flowWaypoint));
+      }
+      else
       {
-        moveTarget = m_path[m_currentPathIndex];
+        moveTarget = m_targetPos;
       }
     }
   }
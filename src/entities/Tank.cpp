@@ -1,5 +1,6 @@
 #include "Tank.hpp"
 #include "AudioManager.hpp"
+#include "TextureCache.hpp"
 
 Tank::Tank()
     : m_healthBar(200.f, 20.f)
@@ -21,21 +22,22 @@ Tank::Tank(float x, float y, sf::Color color)
 
 bool Tank::loadTextures(const std::string &hullPath, const std::string &turretPath)
 {
-  if (!m_hullTexture.loadFromFile(hullPath))
-    return false;
-  if (!m_turretTexture.loadFromFile(turretPath))
+  TextureCache &cache = TextureCache::getInstance();
+  m_hullTexture = cache.acquire(hullPath);
+  m_turretTexture = cache.acquire(turretPath);
+  if (!m_hullTexture || !m_turretTexture)
     return false;
 
   // 创建并设置车身
-  m_hull = std::make_unique<sf::Sprite>(m_hullTexture);
-  m_hull->setOrigin(sf::Vector2f(m_hullTexture.getSize()) / 2.f);
+  m_hull = std::make_unique<sf::Sprite>(*m_hullTexture);
+  m_hull->setOrigin(sf::Vector2f(m_hullTexture->getSize()) / 2.f);
   m_hull->setPosition({640.f, 360.f});
   m_hull->setScale({m_scale, m_scale});
 
   // 创建并设置炮塔
-  m_turret = std::make_unique<sf::Sprite>(m_turretTexture);
+  m_turret = std::make_unique<sf::Sprite>(*m_turretTexture);
   // 炮塔旋转中心在底部中心（炮塔底座位置）
-  auto turretSize = sf::Vector2f(m_turretTexture.getSize());
+  auto turretSize = sf::Vector2f(m_turretTexture->getSize());
   m_turret->setOrigin({turretSize.x / 2.f, turretSize.y * 0.75f});
   m_turret->setScale({m_scale, m_scale});
 
@@ -88,6 +90,12 @@ void Tank::handleInput(const sf::Event &event)
 }
 
 void Tank::update(float dt, sf::Vector2f mousePos)
+{
+  updateShooting(dt);
+  updateMovement(dt, mousePos);
+}
+
+void Tank::updateShooting(float dt)
 {
   // 更新射击计时器
   m_shootTimer += dt;
@@ -98,7 +106,10 @@ void Tank::update(float dt, sf::Vector2f mousePos)
     m_firedBullet = true;
     m_shootTimer = 0.f;
   }
+}
 
+void Tank::updateMovement(float dt, sf::Vector2f mousePos)
+{
   // 计算移动
   sf::Vector2f movement{0.f, 0.f};
   if (m_keyW)
@@ -223,6 +234,20 @@ void Tank::takeDamage(float damage)
   m_healthBar.setHealth(m_healthBar.getHealth() - damage);
 }
 
+std::uint8_t Tank::getMoveKeys() const
+{
+  return static_cast<std::uint8_t>((m_keyW ? MoveUp : 0) | (m_keyS ? MoveDown : 0) |
+                                   (m_keyA ? MoveLeft : 0) | (m_keyD ? MoveRight : 0));
+}
+
+void Tank::setMoveKeys(std::uint8_t keys)
+{
+  m_keyW = (keys & MoveUp) != 0;
+  m_keyS = (keys & MoveDown) != 0;
+  m_keyA = (keys & MoveLeft) != 0;
+  m_keyD = (keys & MoveRight) != 0;
+}
+
 sf::Vector2f Tank::getMovement(float dt) const
 {
   sf::Vector2f movement{0.f, 0.f};
@@ -8,6 +8,7 @@
 #include "Enemy.hpp"
 #include "Maze.hpp"
 #include "MazeGenerator.hpp"
+#include "MazePool.hpp"
 #include "NetworkManager.hpp"
 #include "MultiplayerHandler.hpp"
 #include "AudioManager.hpp"
@@ -101,9 +102,12 @@ private:
   void checkMultiplayerCollisions();
   void spawnEnemies();
   void resetGame();
-  void startGame();
+  void startGame(bool useSavedMaze = false); // useSavedMaze：重玩存档的迷宫（读取失败时随机生成）
   void updateCamera();
   void generateRandomMaze();
+  void generateMultiplayerMaze(int width, int height, int npcCount); // 房主生成联机地图并同步种子
+  MazeRecipe singlePlayerMazeSettings() const;                        // 当前菜单设置对应的单人迷宫参数
+  MazeRecipe multiplayerMazeSettings(int width, int height, int npcCount) const;
   void handleWindowResize(); // 处理窗口大小变化，保持宽高比
 
   // 网络回调
@@ -135,6 +139,7 @@ private:
   std::vector<std::unique_ptr<Bullet>> m_bullets;
   Maze m_maze;
   MazeGenerator m_mazeGenerator;
+  MazePool m_mazePool{1, 2}; // 后台预生成：1 个工作线程，按当前设置保持 2 个迷宫
 
   sf::Font m_font;
 
@@ -179,6 +184,10 @@ private:
   // 暗黑模式（创建房间时选择）
   bool m_darkModeOption = false;
 
+  // 网络节拍频率选项（创建房间时选择，随迷宫数据同步给对方）
+  std::vector<int> m_tickRateOptions = {20, 30, 60};
+  int m_tickRateIndex = 1; // 默认 30 Hz
+
   bool m_gameOver = false;
   bool m_gameWon = false;
 
@@ -191,6 +200,11 @@ private:
   // 音频相关
   bool m_exitVisible = false; // 终点是否在视野内
 
+  // 迷宫存档（单人结算界面按 S 保存当前迷宫，按 L 重玩存档）
+  // 与其他资源一样相对 getResourcePath()，不依赖启动时的工作目录
+  static constexpr const char *SAVED_MAZE_FILE = "saved_maze.tmaz";
+  std::string m_mazeSaveStatus; // 结算界面显示的存档/读档结果
+
   // 获取多人模式上下文
   MultiplayerContext getMultiplayerContext();
 
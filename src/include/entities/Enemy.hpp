@@ -5,6 +5,7 @@
 #include <vector>
 #include "Utils.hpp"
 #include "HealthBar.hpp"
+#include "FlowField.hpp"
 
 // 前向声明
 class Maze;
@@ -46,7 +47,7 @@ public:
   bool isPrimaryTargetDowned() const { return m_primaryTargetDowned; }
   void setPrimaryTargetDowned(bool downed) { m_primaryTargetDowned = downed; }
 
-  // 加载激活状态贴图（Color_C）
+  // 切换到激活状态贴图（Color_C，已在 loadTextures 中预先获取）
   bool loadActivatedTextures();
 
   // 检查玩家是否在激活范围内（用于显示提示）
@@ -86,8 +87,11 @@ public:
   // （已移除）网络插值相关 - 未在工程中使用
 
 private:
-  sf::Texture m_hullTexture;
-  sf::Texture m_turretTexture;
+  // 纹理来自 TextureCache，所有敌人共享
+  std::shared_ptr<const sf::Texture> m_hullTexture;
+  std::shared_ptr<const sf::Texture> m_turretTexture;
+  std::shared_ptr<const sf::Texture> m_activatedHullTexture;
+  std::shared_ptr<const sf::Texture> m_activatedTurretTexture;
   std::unique_ptr<sf::Sprite> m_hull;
   std::unique_ptr<sf::Sprite> m_turret;
 
@@ -97,9 +101,13 @@ private:
   sf::Vector2f m_moveDirection;
   sf::Vector2f m_bounds = {1280.f, 720.f};
 
-  // A* 寻路
-  std::vector<sf::Vector2f> m_path;
-  size_t m_currentPathIndex = 0;
+  // 流场寻路（迷宫为每个目标共享的流场）
+  // 重新规划时取得流场并一直沿用到下次规划；流场被迷宫改作他用或地图变化时提前重新规划
+  std::shared_ptr<const FlowField> m_flowField; // 为空表示需要重新规划
+  int m_flowGoal = -1;                          // 规划时的目标格子
+  std::uint32_t m_flowTileVersion = 0;          // 规划时的地图版本
+  int m_flowWaypoint = -1;                      // 当前前往的格子索引，-1 表示已到目标格子或不可达
+  bool m_followBreachField = false;             // 是否沿流场的穿墙路径前进
   sf::Clock m_pathUpdateClock;
   const float m_pathUpdateInterval = 0.5f; // 每0.5秒更新路径
 
@@ -127,6 +135,7 @@ private:
 
   // 配置
   const float m_moveSpeed = 120.f;
+  const float m_destructibleWallCost = 10.f; // 穿墙路径中可破坏墙的代价
   const float m_rotationSpeed = 3.f;
   const float m_scale = 0.175f; // 原0.25的70%
   const float m_gunLength = 25.f;
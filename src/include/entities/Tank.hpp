@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <cstdint>
 #include <memory>
 #include "Utils.hpp"
 #include "HealthBar.hpp"
@@ -15,6 +16,21 @@ public:
 
   void handleInput(const sf::Event &event);
   void update(float dt, sf::Vector2f mousePos);
+
+  // update 的两部分：射击计时 / 移动和转向（网络预测回放输入时只调用后者）
+  void updateShooting(float dt);
+  void updateMovement(float dt, sf::Vector2f mousePos);
+
+  // 移动按键位掩码（记录和回放输入用）
+  enum MoveKey : std::uint8_t
+  {
+    MoveUp = 1 << 0,
+    MoveDown = 1 << 1,
+    MoveLeft = 1 << 2,
+    MoveRight = 1 << 3,
+  };
+  std::uint8_t getMoveKeys() const;
+  void setMoveKeys(std::uint8_t keys);
   void draw(sf::RenderWindow &window) const;
   void render(sf::RenderWindow &window) const { draw(window); }
   void drawUI(sf::RenderWindow &window) const; // 绘制 UI（血条在左上角）
@@ -108,8 +124,9 @@ public:
   void setTeam(int team) { m_team = team; }
 
 private:
-  sf::Texture m_hullTexture;
-  sf::Texture m_turretTexture;
+  // 纹理来自 TextureCache
+  std::shared_ptr<const sf::Texture> m_hullTexture;
+  std::shared_ptr<const sf::Texture> m_turretTexture;
   std::unique_ptr<sf::Sprite> m_hull;
   std::unique_ptr<sf::Sprite> m_turret;
 
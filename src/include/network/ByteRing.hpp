@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// 可增长的字节环形缓冲区（用于发送队列）
+// 写入追加在尾部，读取从头部开始；容量不足时按 2 倍扩容
+class ByteRing
+{
+public:
+  explicit ByteRing(std::size_t initialCapacity = 4096);
+
+  // 追加数据
+  void write(const std::uint8_t *data, std::size_t size);
+
+  // 头部连续可读的一段（数据跨越末尾时只返回前半段）
+  std::span<const std::uint8_t> front() const;
+
+  // 丢弃头部 size 个字节
+  void consume(std::size_t size);
+
+  void clear();
+
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  std::size_t capacity() const { return m_buffer.size(); }
+
+private:
+  void grow(std::size_t minCapacity);
+
+  std::vector<std::uint8_t> m_buffer;
+  std::size_t m_head = 0; // 第一个可读字节
+  std::size_t m_size = 0;
+};
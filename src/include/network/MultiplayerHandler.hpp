@@ -10,6 +10,8 @@
 #include "Enemy.hpp"
 #include "Maze.hpp"
 #include "NetworkManager.hpp"
+#include "SnapshotInterpolation.hpp"
+#include "Prediction.hpp"
 
 // 多人模式状态
 struct MultiplayerState
@@ -22,9 +24,10 @@ struct MultiplayerState
   std::string roomCode;
   std::string connectionStatus = "Enter server IP:";
   int npcSyncCounter = 0;
+  bool networkTick = false; // 本帧是否经过网络节拍边界（状态消息只在节拍边界发送）
   int nearbyNpcIndex = -1;
   bool rKeyJustPressed = false;
-  std::vector<std::string> generatedMazeData;
+  std::vector<std::uint8_t> packedMaze; // 本局迷宫（MazeCodec 压缩格式）
 
   // Escape 模式相关
   bool isEscapeMode = false;    // 是否是 Escape 模式（否则是 Battle 模式）
@@ -53,6 +56,16 @@ struct MultiplayerState
   int mazeWidth = 41;             // 迷宫宽度
   int mazeHeight = 31;            // 迷宫高度
   bool isDarkMode = false;        // 是否是暗黑模式
+
+  // 远端实体的快照插值（收到的状态先入缓冲区，每帧按固定延迟插值后再设置）
+  RemoteClock remoteClock;
+  SnapshotBuffer otherPlayerSnapshots;
+  std::vector<SnapshotBuffer> npcSnapshots; // 按 NPC ID（仅非房主使用）
+
+  // 客户端预测：非房主记录输入并在收到纠正后回放，房主按这些输入模拟对方坦克
+  InputHistory inputHistory;
+  InputAuthority guestAuthority;
+  std::vector<InputCommand> inputScratch; // 复用的发送缓冲
 };
 
 // 多人游戏渲染和更新所需的上下文
@@ -116,6 +129,11 @@ public:
   static void cleanup();
 
 private:
+  // 把插值后的远端状态应用到对方坦克和NPC（非房主）
+  static void applyRemoteSnapshots(
+      MultiplayerContext &ctx,
+      MultiplayerState &state);
+
   // 更新NPC AI逻辑（仅房主执行）
   static void updateNpcAI(
       MultiplayerContext &ctx,
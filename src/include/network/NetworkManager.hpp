@@ -2,11 +2,24 @@
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Network.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <span>
 #include <string>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <queue>
 #include <mutex>
 #include <functional>
+#include "ByteRing.hpp"
+#include "SpscQueue.hpp"
+#include "StateCodec.hpp"
+#include "NpcSnapshot.hpp"
+#include "MazeGenerator.hpp"
 
 // 网络消息类型
 enum class NetMessageType : uint8_t
@@ -27,7 +40,7 @@ enum class NetMessageType : uint8_t
   // 游戏状态同步
   PlayerUpdate,   // 玩家位置、角度等
   PlayerShoot,    // 玩家射击
-  MazeData,       // 迷宫数据
+  MazeData,       // 迷宫数据：模式标志(1) + 节拍频率(1) + MazeCodec 压缩数据
   RequestMaze,    // 请求迷宫数据
   ReachExit,      // 到达终点
   GameWin,        // 游戏胜利（先到终点）
@@ -36,7 +49,7 @@ enum class NetMessageType : uint8_t
 
   // NPC同步
   NpcActivate, // NPC激活
-  NpcUpdate,   // NPC状态更新（位置、血量等）
+  NpcUpdate,   // NPC状态更新（已由 NpcSnapshot 取代，保留以免后续编号变化）
   NpcShoot,    // NPC射击
   NpcDamage,   // NPC受伤
 
@@ -62,6 +75,26 @@ enum class NetMessageType : uint8_t
 
   // 墙壁伤害同步
   WallDamage, // 墙壁受到伤害
+
+  // 批量消息：一帧内的多条消息合并为一个包
+  // 格式：Batch + 若干个 [长度(2) + 消息]
+  Batch,
+
+  // UDP 已确认可用（客户端收到服务器回显的登记数据报后通过 TCP 告知服务器）
+  // 服务器只向已确认的玩家转发 UDP，其余玩家的状态消息改走 TCP
+  UdpReady,
+
+  // NPC 增量快照：只发送相对已确认基准的变化，格式见 NpcSnapshot.hpp
+  NpcSnapshot,
+  NpcSnapshotAck, // 确认收到快照：快照ID(2)
+
+  // 客户端预测：非房主发送输入，房主按输入模拟并发回权威位置
+  PlayerInput,      // 数量(1) + 若干个 [输入序号(4) + 按键(1) + 帧时间(2，0.1ms)]
+  PlayerCorrection, // 已处理的最新输入序号(4) + x(4) + y(4) + 车身角度(4)
+
+  // 种子同步迷宫：模式标志(1) + 种子(4) + 宽(2) + 高(2) + NPC数量(2) + 校验和(4) + 节拍频率(1)
+  // 对方用相同参数生成迷宫，校验和不一致时发送 RequestMaze 改为完整传输（MazeData）
+  MazeSeed,
 };
 
 // 玩家状态数据
@@ -73,6 +106,7 @@ struct PlayerState
   float health = 100;
   bool reachedExit = false;
   bool isDead = false; // 是否已死亡（可被救援）
+  uint32_t tick = 0;   // 发送方的网络节拍编号（发送时由 NetworkManager 填写）
 };
 
 // NPC状态数据
@@ -85,6 +119,16 @@ struct NpcState
   float health = 100;
   int team = 0;
   bool activated = false;
+  uint32_t tick = 0; // 所属快照的网络节拍编号
+};
+
+// 一帧的移动输入（客户端预测）
+struct InputCommand
+{
+  uint32_t sequence = 0; // 输入序号（每帧递增）
+  uint8_t keys = 0;      // Tank::MoveKey 位掩码
+  float dt = 0.f;        // 帧时间（已量化，两端模拟结果一致）
+  sf::Vector2f aim;      // 炮塔瞄准点（只在本地回放时使用，不发送）
 };
 
 // 回调类型
@@ -93,7 +137,7 @@ using OnDisconnectedCallback = std::function<void()>;
 using OnRoomCreatedCallback = std::function<void(const std::string &roomCode)>;
 using OnRoomJoinedCallback = std::function<void(const std::string &roomCode)>;
 using OnGameStartCallback = std::function<void()>;
-using OnMazeDataCallback = std::function<void(const std::vector<std::string> &mazeData, bool isDarkMode)>;
+using OnMazeDataCallback = std::function<void(std::span<const uint8_t> packedMaze, bool isDarkMode)>; // MazeCodec 压缩格式
 using OnRequestMazeCallback = std::function<void()>;
 using OnPlayerUpdateCallback = std::function<void(const PlayerState &state)>;
 using OnPlayerShootCallback = std::function<void(float x, float y, float angle)>;
@@ -114,6 +158,8 @@ using OnRescueCancelCallback = std::function<void()>;
 using OnGameModeReceivedCallback = std::function<void(bool isEscapeMode)>;
 using OnPlayerReadyCallback = std::function<void(bool isReady)>;
 using OnRoomInfoCallback = std::function<void(const std::string &hostIP, const std::string &guestIP, bool guestReady, bool isDarkMode)>;
+using OnPlayerInputCallback = std::function<void(std::span<const InputCommand> inputs)>;
+using OnPlayerCorrectionCallback = std::function<void(uint32_t lastInput, sf::Vector2f position, float rotation)>;
 using OnWallDamageCallback = std::function<void(int row, int col, float damage, bool destroyed, int attribute, int destroyerId)>;
 
 class NetworkManager
@@ -134,8 +180,14 @@ public:
   void createRoom(int mazeWidth, int mazeHeight, bool isDarkMode = false);
   void joinRoom(const std::string &roomCode);
 
-  // 发送迷宫数据（房主调用）
-  void sendMazeData(const std::vector<std::string> &mazeData, bool isEscapeMode = false, bool isDarkMode = false);
+  // 发送迷宫数据（房主调用），packedMaze 为 MazeCodec 压缩格式
+  void sendMazeData(std::span<const uint8_t> packedMaze, bool isEscapeMode = false, bool isDarkMode = false);
+  // 只发送迷宫的生成参数和校验和（房主调用），对方生成失败时会请求完整数据
+  void sendMazeSeed(const MazeRecipe &recipe, uint32_t checksum, bool isDarkMode = false);
+  // 请求房主发送完整迷宫数据（非房主调用）
+  void sendRequestMaze();
+  // 根据迷宫大小设置状态编码的位置范围（两端必须一致；房主只发种子时要自己调用）
+  void setMazeSize(std::size_t rows, std::size_t cols);
 
   // 发送游戏数据
   void sendPosition(const PlayerState &state);
@@ -146,7 +198,12 @@ public:
 
   // NPC同步
   void sendNpcActivate(int npcId, int team, int activatorId = -1); // 发送NPC激活
-  void sendNpcUpdate(const NpcState &state);                       // 发送NPC状态更新
+  void sendNpcSnapshot(std::span<const NpcState> states);          // 发送所有NPC的增量快照
+
+  // 客户端预测
+  static constexpr std::size_t MAX_INPUTS_PER_MESSAGE = 32;
+  void sendPlayerInput(std::span<const InputCommand> inputs);                           // 非房主：发送最近的未确认输入
+  void sendPlayerCorrection(uint32_t lastInput, sf::Vector2f position, float rotation); // 房主：发回权威位置
   void sendNpcShoot(int npcId, float x, float y, float angle);     // 发送NPC射击
   void sendNpcDamage(int npcId, float damage);                     // 发送NPC受伤
   void sendClimaxStart();                                          // 发送开始播放高潮BGM
@@ -165,9 +222,33 @@ public:
   void sendPlayerReady(bool isReady); // 发送准备状态
   void sendHostStartGame();           // 房主发起开始游戏
 
-  // 处理网络消息（在主线程调用）
+  // 处理网络线程收到的消息并触发回调（在主线程调用）
   void update();
 
+  // 帧末调用：把本帧产生的消息合并成一个批量包交给网络线程
+  void flush();
+
+  // UDP 通道是否可用（不可用时状态消息走 TCP）
+  bool isUdpActive() const { return m_udpReady; }
+
+  // 尚未写入套接字的字节数（网络拥塞时增长）
+  std::size_t getQueuedBytes() const { return m_queuedBytes.load(std::memory_order_relaxed) + m_outboundBytes; }
+  // 发送积压过多：可被下一帧覆盖的状态同步可以跳过
+  bool isSendBackedUp() const { return getQueuedBytes() > SEND_BACKLOG_LIMIT; }
+
+  // 当前正在处理的消息被网络线程收到的时间（不受渲染卡顿影响）
+  std::chrono::steady_clock::time_point getReceiveTime() const { return m_receiveTime; }
+
+  // 网络节拍：状态消息按固定频率发送，与渲染帧率无关
+  // 房主创建房间时设置，随迷宫数据发给对方，两端使用相同频率
+  static constexpr int DEFAULT_TICK_RATE = 30;
+  void setTickRate(int ticksPerSecond); // 限制在 [MIN_TICK_RATE, MAX_TICK_RATE]
+  int getTickRate() const { return m_tickRate; }
+  float getTickInterval() const { return 1.f / static_cast<float>(m_tickRate); }
+  uint32_t getTick() const { return m_tick; }
+  // 每帧调用一次：累加帧时间，返回本帧是否经过了节拍边界（是则发送状态消息）
+  bool advanceTick(float dt);
+
   // 设置回调
   void setOnConnected(OnConnectedCallback cb) { m_onConnected = cb; }
   void setOnDisconnected(OnDisconnectedCallback cb) { m_onDisconnected = cb; }
@@ -196,6 +277,8 @@ public:
   void setOnGameModeReceived(OnGameModeReceivedCallback cb) { m_onGameModeReceived = cb; }
   void setOnPlayerReady(OnPlayerReadyCallback cb) { m_onPlayerReady = cb; }
   void setOnRoomInfo(OnRoomInfoCallback cb) { m_onRoomInfo = cb; }
+  void setOnPlayerInput(OnPlayerInputCallback cb) { m_onPlayerInput = cb; }
+  void setOnPlayerCorrection(OnPlayerCorrectionCallback cb) { m_onPlayerCorrection = cb; }
 
   std::string getRoomCode() const { return m_roomCode; }
 
@@ -203,16 +286,137 @@ private:
   NetworkManager() = default;
   ~NetworkManager() { disconnect(); }
 
-  void sendPacket(const std::vector<uint8_t> &data);
-  void receiveData();
-  void processMessage(const std::vector<uint8_t> &data);
-
+  // 网络线程收到的一段数据：若干条完整的 [长度(2) + 消息]
+  struct InboundChunk
+  {
+    std::vector<uint8_t> data;
+    std::chrono::steady_clock::time_point receivedAt;
+  };
+
+  // 按种子在后台生成的迷宫（MazeSeed），完成前收到的消息暂存，保持处理顺序
+  struct PendingMaze
+  {
+    std::vector<uint8_t> packedMaze; // MazeCodec 压缩格式，校验和不一致时为空
+    int rows = 0;
+    int cols = 0;
+    bool escapeMode = false;
+    bool darkMode = false;
+    uint8_t tickRate = 0;
+  };
+
+  // ---- 主线程 ----
+  // 后台生成完成后交给回调，再按顺序处理暂存的消息
+  void finishPendingMaze();
+  // 把消息加入本帧的批量包（不阻塞）
+  void sendPacket(std::span<const uint8_t> data);
+  // 把一条带长度前缀的消息放入待交给网络线程的缓冲区
+  void queueFrame(const uint8_t *data, std::size_t size);
+  // 结束当前批量包
+  void finishBatch();
+  // 状态消息（可被后续消息覆盖）走 UDP；UDP 不可用时退回 TCP
+  void sendState(std::span<const uint8_t> data);
+  // 结束当前 UDP 数据报并交给网络线程
+  void finishDatagram();
+  // 发送只有包头的数据报，让服务器记录本机 UDP 地址（服务器原样回显，收到回显才启用 UDP）
+  void sendUdpRegistration();
+  // 解析一段数据中的所有消息（直接引用缓冲区，不拷贝）
+  void dispatchChunk(std::span<const uint8_t> chunk);
+  void processMessage(std::span<const uint8_t> data);
+
+  void startNetworkThread();
+  void stopNetworkThread();
+  // 清空线程间队列和缓冲区（网络线程已停止时调用）
+  void resetBuffers();
+
+  // ---- 网络线程 ----
+  void networkThreadLoop();
+  // 以非阻塞方式尽量写出发送队列，处理部分发送；返回 false 表示连接已断开
+  bool flushSendQueue();
+  // 循环读取直到套接字没有数据（NotReady），把完整消息交给主线程；返回 false 表示连接已断开
+  bool receiveData();
+  // 把接收缓冲区中的完整消息打包交给主线程；主线程处理不过来时返回 false
+  bool pushReceived();
+  // 发送排队的 UDP 数据报，读取收到的数据报（丢弃过期的）
+  void sendDatagrams();
+  void receiveDatagrams();
+
+  // 连接期间套接字只由网络线程使用
   sf::TcpSocket m_socket;
-  bool m_connected = false;
+  sf::SocketSelector m_selector;
+  std::thread m_thread;
+  std::atomic<bool> m_running{false};
+  std::atomic<bool> m_socketClosed{false}; // 网络线程发现连接断开
+  bool m_connected = false;                // 主线程视角的连接状态
   std::string m_roomCode;
 
-  // 接收缓冲区
+  // UDP 状态通道
+  // 数据报格式：会话ID(4) + 序号(4) + 若干个 [长度(2) + 消息]
+  // 会话ID 由服务器在 ConnectAck 中分配，服务器按会话ID找到房间并原样转发
+  static constexpr std::size_t UDP_HEADER_SIZE = 8;
+  static constexpr std::size_t MAX_DATAGRAM_SIZE = 1200; // 避免 IP 分片
+  sf::UdpSocket m_udpSocket;
+  bool m_udpBound = false;
+  bool m_udpReady = false; // 已收到服务器回显的登记数据报，状态消息改走 UDP
+  std::atomic<bool> m_udpEchoed{false}; // 网络线程：收到了登记回显
+  int m_udpRegisterAttempts = 0;
+  std::chrono::steady_clock::time_point m_udpRegisterSentAt;
+  static constexpr int MAX_UDP_REGISTER_ATTEMPTS = 10;     // 之后一直使用 TCP
+  static constexpr auto UDP_REGISTER_INTERVAL = std::chrono::milliseconds(500);
+  uint32_t m_sessionId = 0;
+  uint32_t m_udpSequence = 0;
+  std::vector<uint8_t> m_datagram;                         // 主线程：正在填充的数据报
+  std::optional<sf::IpAddress> m_serverAddress;
+  unsigned short m_serverPort = 0;
+  std::unordered_map<uint32_t, uint32_t> m_udpLastSequence; // 网络线程：每个发送方最新的序号
+
+  // 线程间队列（各自单生产者/单消费者），用完的缓冲区通过 free 队列送回复用
+  static constexpr std::size_t QUEUE_CAPACITY = 256;
+  SpscQueue<InboundChunk, QUEUE_CAPACITY> m_inbound;                 // 网络线程 -> 主线程
+  SpscQueue<std::vector<uint8_t>, QUEUE_CAPACITY> m_inboundFree;     // 主线程 -> 网络线程
+  SpscQueue<std::vector<uint8_t>, QUEUE_CAPACITY> m_outbound;        // 主线程 -> 网络线程
+  SpscQueue<std::vector<uint8_t>, QUEUE_CAPACITY> m_udpOutbound;     // 主线程 -> 网络线程（数据报）
+  SpscQueue<std::vector<uint8_t>, QUEUE_CAPACITY> m_outboundFree;    // 网络线程 -> 主线程
+
+  // 接收缓冲区（网络线程）：[m_receiveStart, m_receiveEnd) 为未打包的数据
+  static constexpr std::size_t RECEIVE_CHUNK = 4096;
   std::vector<uint8_t> m_receiveBuffer;
+  std::size_t m_receiveStart = 0;
+  std::size_t m_receiveEnd = 0;
+  std::chrono::steady_clock::time_point m_receiveTime; // 主线程：当前消息的接收时间
+
+  // 种子迷宫的后台生成（主线程）
+  std::future<PendingMaze> m_pendingMaze;
+  std::deque<InboundChunk> m_deferredMessages; // 生成期间收到的消息（每条一个）
+
+  // 发送队列（网络线程）
+  static constexpr std::size_t SEND_BACKLOG_LIMIT = 16 * 1024;
+  ByteRing m_sendQueue;
+  std::atomic<std::size_t> m_queuedBytes{0};
+
+  // 玩家/NPC 状态的量化编码
+  StateCodec m_stateCodec;
+
+  // 网络节拍（主线程）
+  static constexpr int MIN_TICK_RATE = 10;
+  static constexpr int MAX_TICK_RATE = 60;
+  int m_tickRate = DEFAULT_TICK_RATE;
+  float m_tickAccumulator = 0.f;
+  uint32_t m_tick = 0;
+
+  // NPC 增量快照（主线程）
+  NpcSnapshotSender m_npcSender;
+  NpcSnapshotReceiver m_npcReceiver;
+  std::vector<uint8_t> m_npcSnapshot;    // 复用的编码缓冲区
+  std::vector<NpcState> m_npcStates;     // 复用的解码结果
+  std::vector<InputCommand> m_inputs;    // 复用的输入解码结果
+
+  // 当前帧的批量包（主线程）
+  static constexpr std::size_t MAX_FRAME_SIZE = 0xFFFF; // 长度前缀为 2 字节
+  std::vector<uint8_t> m_batch;
+  int m_batchCount = 0;
+  std::vector<uint8_t> m_outgoing;                       // 本帧要交给网络线程的数据
+  std::deque<std::vector<uint8_t>> m_outboundOverflow;  // 发送队列满时暂存
+  std::size_t m_outboundBytes = 0;                      // 暂存的字节数
 
   // 回调
   OnConnectedCallback m_onConnected;
@@ -242,4 +446,6 @@ private:
   OnGameModeReceivedCallback m_onGameModeReceived;
   OnPlayerReadyCallback m_onPlayerReady;
   OnRoomInfoCallback m_onRoomInfo;
+  OnPlayerInputCallback m_onPlayerInput;
+  OnPlayerCorrectionCallback m_onPlayerCorrection;
 };
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "StateCodec.hpp"
+
+// NPC 状态的增量复制
+// 房主每次发送一个快照（所有激活 NPC 的状态），只写出相对“对方已确认的基准快照”变化的字段；
+// 对方确认收到后，该快照成为新的基准。基准过旧或定期时发送完整关键帧用于重新同步
+//
+// 消息格式：快照ID(2) + 基准ID(2，KEYFRAME 表示关键帧) + 节拍编号(4) + NPC数量(1) + 位打包的条目
+// 条目：NPC ID(8) + 变化掩码(5) + 变化的字段
+namespace NpcSnapshot
+{
+  constexpr std::uint16_t KEYFRAME = 0xFFFF;
+  constexpr std::size_t HISTORY_SIZE = 64;       // 保留的快照数量（基准必须在其中）
+  constexpr std::size_t HEADER_SIZE = 9;
+
+  // 一个快照中的 NPC（按 ID 排序）
+  struct Frame
+  {
+    std::uint16_t id = KEYFRAME;
+    std::vector<QuantizedNpc> npcs;
+  };
+
+  // 快照ID按差值比较（处理回绕）
+  inline bool isNewer(std::uint16_t a, std::uint16_t b) { return static_cast<std::int16_t>(a - b) > 0; }
+}
+
+// 房主端：编码快照并记录历史
+class NpcSnapshotSender
+{
+public:
+  // 编码一帧快照追加到 out（out 中已有消息类型等前缀），tick 为发送时的网络节拍
+  void encode(std::span<const NpcState> states, std::uint32_t tick, const StateCodec &codec, std::vector<std::uint8_t> &out);
+
+  // 对方确认收到某个快照
+  void acknowledge(std::uint16_t snapshotId);
+
+  // 对方换人或重新开始时调用，下一帧发送关键帧
+  void reset();
+
+private:
+  static constexpr std::uint16_t KEYFRAME_INTERVAL = 120; // 定期关键帧（快照数）
+
+  std::array<NpcSnapshot::Frame, NpcSnapshot::HISTORY_SIZE> m_history;
+  std::uint16_t m_nextId = 0;
+  std::uint16_t m_ackedId = NpcSnapshot::KEYFRAME; // 未确认
+  std::uint16_t m_sinceKeyframe = 0;
+  bool m_hasAck = false;
+};
+
+// 接收端：根据基准还原快照
+class NpcSnapshotReceiver
+{
+public:
+  // 解码快照，outStates 为还原后所有 NPC 的完整状态（tick 为快照的节拍编号）
+  // 基准已不在历史中时返回 false（等待关键帧）
+  bool decode(std::span<const std::uint8_t> data, const StateCodec &codec,
+              std::vector<NpcState> &outStates, std::uint16_t &outSnapshotId);
+
+  void reset();
+
+private:
+  std::array<NpcSnapshot::Frame, NpcSnapshot::HISTORY_SIZE> m_history;
+};
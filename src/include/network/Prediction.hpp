@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+#include "NetworkManager.hpp"
+#include "Tank.hpp"
+#include "Maze.hpp"
+
+// 客户端预测
+// 非房主每帧记录输入并立即在本地执行；房主按收到的输入模拟同一辆坦克，定期发回
+// “已处理到第几条输入 + 此时的位置”。非房主收到后从该位置出发重新执行之后的输入，
+// 因此纠正不会带来输入延迟，网络节拍可以设得更低
+
+// 输入帧时间的量化精度（两端用同样的 dt 模拟，结果才会一致）
+constexpr float INPUT_DT_STEPS_PER_SECOND = 10000.f;
+constexpr float MAX_INPUT_DT = 0.1f; // 单条输入最多推进的时间（防止卡顿或异常数据造成瞬移）
+
+// 量化帧时间（截断到 [0, MAX_INPUT_DT]）
+float quantizeInputDt(float dt);
+
+// 按一条输入推进坦克移动并处理墙壁碰撞（贴墙滑动）
+// 本地更新、房主模拟和回放共用这一段代码
+void stepTank(Tank &tank, const Maze &maze, const InputCommand &input);
+
+// 非房主的输入历史
+class InputHistory
+{
+public:
+  // 记录本帧输入，返回带序号的输入
+  const InputCommand &record(std::uint8_t keys, float dt, sf::Vector2f aim);
+
+  // 最近的未确认输入（最多 MAX_INPUTS_PER_MESSAGE 条），按序号递增
+  void recent(std::vector<InputCommand> &out) const;
+
+  // 房主确认已处理到 sequence：丢弃之前的输入；返回 false 表示是过期的确认
+  bool acknowledge(std::uint32_t sequence);
+
+  // 从纠正后的状态重新执行所有未确认输入（不触发射击）
+  void replay(Tank &tank, const Maze &maze) const;
+
+  bool empty() const { return m_pending.empty(); }
+  void clear();
+
+private:
+  static constexpr std::size_t MAX_PENDING = 256; // 超出时丢弃最旧的（房主长时间没有确认）
+
+  std::deque<InputCommand> m_pending;
+  std::uint32_t m_nextSequence = 1;
+  std::uint32_t m_lastAck = 0;
+};
+
+// 房主：按非房主的输入模拟其坦克
+class InputAuthority
+{
+public:
+  // 从出生点开始模拟
+  void reset(sf::Vector2f spawn, float scale);
+
+  // 按序执行新输入（已处理过的序号忽略）
+  void apply(std::span<const InputCommand> inputs, const Maze &maze);
+
+  // 有新处理的输入时返回 true，并清除标记（每个节拍最多发一次纠正）
+  bool takeCorrection();
+
+  bool isActive() const { return m_tank != nullptr; }
+  void clear() { m_tank.reset(); }
+  std::uint32_t getLastInput() const { return m_lastInput; }
+  const Tank &getTank() const { return *m_tank; }
+
+private:
+  std::unique_ptr<Tank> m_tank;
+  std::uint32_t m_lastInput = 0;
+  bool m_dirty = false;
+};
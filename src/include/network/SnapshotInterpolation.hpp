@@ -0,0 +1,76 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// 远端实体的快照插值
+// 收到的状态按发送方节拍编号换算成发送方时间存入缓冲区，渲染时显示“略早于最新数据”的时刻，
+// 在前后两个快照之间插值；数据断流时短暂外推。网络节拍较低时画面仍能按帧率平滑移动
+// 要求两端使用相同的网络节拍频率
+
+// 一个实体在某个时刻的显示状态
+struct EntitySnapshot
+{
+  double time = 0.0; // 发送方时间（秒）
+  sf::Vector2f position;
+  float rotation = 0.f;
+  float turretAngle = 0.f;
+};
+
+// 估计发送方时间与本地时间的对应关系
+class RemoteClock
+{
+public:
+  // 插值延迟（节拍数）：按当前网络节拍换算，任何节拍频率下都能覆盖一个丢失的包和到达时间抖动
+  static constexpr double INTERPOLATION_TICKS = 3.0;
+
+  // 收到一条带节拍编号的消息，返回它的发送方时间
+  double observe(std::uint32_t tick, float tickInterval, std::chrono::steady_clock::time_point receivedAt);
+
+  // 当前应显示的发送方时间（已减去 INTERPOLATION_TICKS 个节拍的插值延迟）
+  double renderTime(std::chrono::steady_clock::time_point now, float tickInterval) const;
+
+  // 已收到的最新发送方时间
+  double latestTime() const { return m_latest; }
+  bool isValid() const { return m_valid; }
+  void reset() { m_valid = false; }
+
+private:
+  // 偏移（本地时间 - 发送方时间）跟随最快到达的包，较晚到达的包只让它缓慢上移（适应延迟变化和时钟漂移）
+  static constexpr double OFFSET_DRIFT = 0.01;
+  static constexpr double RESYNC_THRESHOLD = 1.0; // 偏差超过该值（如对方重连后节拍归零）时重新同步
+
+  double localSeconds(std::chrono::steady_clock::time_point time) const;
+
+  std::chrono::steady_clock::time_point m_epoch;
+  double m_offset = 0.0;
+  double m_latest = 0.0;
+  bool m_valid = false;
+};
+
+// 单个实体的快照缓冲区（按时间递增的环形数组）
+class SnapshotBuffer
+{
+public:
+  // 加入快照（比已有的最新快照旧的直接丢弃）
+  void push(const EntitySnapshot &snapshot);
+
+  // 取 renderTime 时刻的状态：在前后两个快照间插值；超出最新快照时外推（最多 MAX_EXTRAPOLATION 秒）
+  // 缓冲区为空时返回 false
+  bool sample(double renderTime, EntitySnapshot &out) const;
+
+  bool empty() const { return m_count == 0; }
+  void clear() { m_count = 0; }
+
+private:
+  static constexpr std::size_t CAPACITY = 32;
+  static constexpr double MAX_EXTRAPOLATION = 0.25;
+
+  const EntitySnapshot &at(std::size_t index) const { return m_items[(m_start + index) % CAPACITY]; }
+
+  std::array<EntitySnapshot, CAPACITY> m_items;
+  std::size_t m_start = 0;
+  std::size_t m_count = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// 单生产者/单消费者无锁队列（固定容量环形数组）
+// 只允许一个线程 push、另一个线程 pop；Capacity 必须是 2 的幂
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+  // 生产者调用；队列已满时返回 false，value 保持不变
+  bool push(T &&value)
+  {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+      return false;
+
+    m_slots[tail & (Capacity - 1)] = std::move(value);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 消费者调用；队列为空时返回 false
+  bool pop(T &out)
+  {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+      return false;
+
+    out = std::move(m_slots[head & (Capacity - 1)]);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const
+  {
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+  }
+
+private:
+  std::array<T, Capacity> m_slots;
+  // 头尾索引分开放在不同缓存行，避免两个线程互相干扰
+  alignas(64) std::atomic<std::size_t> m_head{0}; // 消费者写
+  alignas(64) std::atomic<std::size_t> m_tail{0}; // 生产者写
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+struct PlayerState;
+struct NpcState;
+
+// 按位写入（低位在前），写入调用方预先分配的缓冲区
+class BitWriter
+{
+public:
+  BitWriter(std::uint8_t *data, std::size_t capacity);
+
+  void write(std::uint32_t value, int bits);
+
+  // 已写入的字节数（不足一字节按一字节计）
+  std::size_t bytes() const { return (m_bitPos + 7) / 8; }
+  bool overflowed() const { return m_overflow; }
+
+private:
+  std::uint8_t *m_data;
+  std::size_t m_capacity;
+  std::size_t m_bitPos = 0;
+  bool m_overflow = false;
+};
+
+// 按位读取，与 BitWriter 对应
+class BitReader
+{
+public:
+  explicit BitReader(std::span<const std::uint8_t> data);
+
+  std::uint32_t read(int bits);
+  bool overflowed() const { return m_overflow; }
+
+private:
+  std::span<const std::uint8_t> m_data;
+  std::size_t m_bitPos = 0;
+  bool m_overflow = false;
+};
+
+// 量化后的 NPC 状态（快照基准的存储格式，发送端和接收端逐位一致）
+struct QuantizedNpc
+{
+  std::uint8_t id = 0;
+  std::uint32_t x = 0, y = 0;
+  std::uint16_t rotation = 0;
+  std::uint16_t turretAngle = 0;
+  std::uint8_t health = 0;
+  std::uint8_t team = 0;
+  bool activated = false;
+};
+
+// NPC 字段变化掩码
+enum NpcField : std::uint8_t
+{
+  NpcFieldPosition = 1 << 0,
+  NpcFieldRotation = 1 << 1,
+  NpcFieldTurret = 1 << 2,
+  NpcFieldHealth = 1 << 3,
+  NpcFieldFlags = 1 << 4, // 阵营 + 激活状态
+  NpcFieldAll = (1 << 5) - 1,
+};
+
+// 玩家/NPC 状态的量化编码
+// 位置：相对地图范围的定点数（精度 1/4 像素，位数由地图大小决定）
+// 角度：12 位；血量：1 字节（0.5 精度）；布尔值和阵营：位域；玩家状态带 32 位节拍编号
+class StateCodec
+{
+public:
+  static constexpr std::size_t MAX_STATE_BYTES = 16;
+
+  // 两端必须使用相同的地图大小（加载迷宫时设置）
+  void setWorldSize(sf::Vector2f size);
+
+  // 编码到 out（至少 MAX_STATE_BYTES），返回写入的字节数
+  std::size_t encodePlayer(const PlayerState &state, std::uint8_t *out) const;
+  bool decodePlayer(std::span<const std::uint8_t> data, PlayerState &state) const;
+
+  // NPC：先量化，再按变化掩码只写出变化的字段
+  QuantizedNpc quantizeNpc(const NpcState &state) const;
+  NpcState dequantizeNpc(const QuantizedNpc &npc) const;
+  static std::uint8_t diffNpc(const QuantizedNpc &baseline, const QuantizedNpc &current);
+  void writeNpcFields(BitWriter &writer, const QuantizedNpc &npc, std::uint8_t mask) const;
+  void readNpcFields(BitReader &reader, QuantizedNpc &npc, std::uint8_t mask) const;
+
+private:
+  static constexpr int ANGLE_BITS = 12;
+  static constexpr float POSITION_STEPS_PER_PIXEL = 4.f;
+  static constexpr float HEALTH_SCALE = 2.f;
+
+  std::uint32_t quantizePosition(float value, int axis) const;
+  void writePosition(BitWriter &writer, float x, float y) const;
+  void readPosition(BitReader &reader, float &x, float &y) const;
+
+  static std::uint32_t quantizeAngle(float degrees);
+  static float dequantizeAngle(std::uint32_t value);
+  static std::uint32_t quantizeHealth(float health);
+
+  sf::Vector2f m_worldSize = {0.f, 0.f};
+  int m_positionBits[2] = {16, 16};
+};
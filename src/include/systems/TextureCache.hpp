@@ -0,0 +1,29 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// 全局纹理缓存：按路径只从磁盘加载一次，Tank / Enemy 共享同一份纹理
+// 返回的 shared_ptr 即引用计数，最后一个使用者释放后纹理随之释放
+class TextureCache
+{
+public:
+  static TextureCache &getInstance();
+
+  // 获取纹理（未加载时从磁盘加载），失败返回 nullptr
+  std::shared_ptr<const sf::Texture> acquire(const std::string &path);
+
+  // 当前仍在使用的纹理数量
+  std::size_t size() const;
+
+private:
+  TextureCache() = default;
+  ~TextureCache() = default;
+  TextureCache(const TextureCache &) = delete;
+  TextureCache &operator=(const TextureCache &) = delete;
+
+  // 只保存弱引用，缓存本身不延长纹理的生命周期
+  std::unordered_map<std::string, std::weak_ptr<const sf::Texture>> m_textures;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+enum class WallType : std::uint8_t;
+
+// 流场中的两种路径
+enum class FlowLabel
+{
+  Open = 0,  // 只走空地
+  Breach = 1 // 允许穿过可破坏墙（代价较高）
+};
+
+// 流场：从目标格子反向做一次 Dijkstra，得到每个格子到目标的代价和前进方向
+// 追同一个目标的所有敌人共用一个流场，每个敌人只需 O(1) 查询自己所在格子
+// 开放路径和穿墙路径在同一次扩展中求出：穿墙最优路径上没有可破坏墙时，两者共享结果
+// 节点数组在重建之间复用，用代数标记区分本次构建写入的节点，重建前不需要清空
+class FlowField
+{
+public:
+  // 从 goal 反向构建，tiles 为行优先的格子类型数组
+  // destructibleCost 为穿过可破坏墙的代价（< 0 时穿墙路径与开放路径相同）
+  void build(const WallType *tiles, int rows, int cols, int goal, float destructibleCost);
+
+  bool isReachable(int tile, FlowLabel label) const
+  {
+    return tile >= 0 && tile < m_tileCount && visited(node(tile, label));
+  }
+
+  // 到目标的总代价
+  float getCost(int tile, FlowLabel label) const { return costOf(node(tile, label)); }
+
+  // 到目标的步数（格子数）
+  int getSteps(int tile, FlowLabel label) const
+  {
+    const int id = node(tile, label);
+    return visited(id) ? m_steps[id] : -1;
+  }
+
+  // 朝目标前进一步的格子，-1 表示已在目标或不可达
+  int getNextTile(int tile, FlowLabel label) const
+  {
+    const int id = node(tile, label);
+    return visited(id) ? m_next[id] : -1;
+  }
+
+  // 沿穿墙路径前进遇到的第一个可破坏墙（不含自身），-1 表示没有
+  int getFirstBreach(int tile) const
+  {
+    int next = getNextTile(tile, FlowLabel::Breach);
+    return next >= 0 ? m_firstBreach[next] : -1;
+  }
+
+  int getGoal() const { return m_goal; }
+  float getDestructibleCost() const { return m_destructibleCost; }
+
+private:
+  static int node(int tile, FlowLabel label) { return tile * 2 + static_cast<int>(label); }
+
+  // 代数标记不是本次构建的节点视为未访问（不可达）
+  bool visited(int id) const { return m_stamp[id] == m_generation; }
+  float costOf(int id) const { return visited(id) ? m_cost[id] : std::numeric_limits<float>::max(); }
+
+  // 以下数组按节点（tile * 2 + label）存放，只有 visited 的节点内容有效
+  std::vector<float> m_cost;
+  std::vector<int> m_steps;
+  std::vector<int> m_next;
+  std::vector<std::uint32_t> m_stamp;   // 写入该节点的构建代数
+  std::vector<std::uint32_t> m_settled; // 该节点出堆确定时的构建代数
+  std::uint32_t m_generation = 0;
+
+  std::vector<int> m_firstBreach; // 按格子：沿穿墙路径（含自身）遇到的第一个可破坏墙，穿墙节点已访问时有效
+  std::vector<std::pair<float, int>> m_heap;
+  int m_tileCount = 0;
+  int m_goal = -1;
+  float m_destructibleCost = 0.f;
+};
@@ -1,16 +1,21 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 #include <string>
-#include <queue>
-#include <unordered_map>
 #include "MazeGenerator.hpp"
+#include "MazeCodec.hpp"
+#include "FlowField.hpp"
 #include "Utils.hpp"
-#include "RoundedRectangle.hpp"
+#include "MazeRenderer.hpp"
 
 // 墙体类型
-enum class WallType
+enum class WallType : std::uint8_t
 {
   None,         // 空地
   Destructible, // 可破坏墙体
@@ -19,7 +24,7 @@ enum class WallType
 };
 
 // 可破坏墙体属性
-enum class WallAttribute
+enum class WallAttribute : std::uint8_t
 {
   None, // 无属性（普通）
   Gold, // 金色 - 打掉获得2金币
@@ -39,18 +44,8 @@ struct WallDestroyResult
 // 圆角半径常量
 constexpr float WALL_CORNER_RADIUS = 12.f;
 
-// 单个墙体
-struct Wall
-{
-  SelectiveRoundedRectShape shape;
-  WallType type;
-  WallAttribute attribute; // 墙体属性
-  float health;
-  float maxHealth;
-  std::array<bool, 4> roundedCorners; // [左上, 右上, 右下, 左下]
-
-  Wall() : shape({0, 0}, WALL_CORNER_RADIUS, 6), type(WallType::None), attribute(WallAttribute::None), health(0), maxHealth(0), roundedCorners({false, false, false, false}) {}
-};
+// 可破坏墙体满血值
+constexpr float WALL_MAX_HEALTH = 100.f;
 
 // 网格坐标
 struct GridPos
@@ -60,15 +55,6 @@ struct GridPos
   bool operator!=(const GridPos &other) const { return !(*this == other); }
 };
 
-// GridPos 哈希函数
-struct GridPosHash
-{
-  std::size_t operator()(const GridPos &pos) const
-  {
-    return std::hash<int>()(pos.x) ^ (std::hash<int>()(pos.y) << 16);
-  }
-};
-
 class Maze
 {
 public:
@@ -83,16 +69,28 @@ public:
   // 'X' = 敌人位置
   void loadFromString(const std::vector<std::string> &map);
 
+  // 从压缩格式（MazeCodec）加载，直接解码到格子数组，数据无效时返回 false 且不改变当前迷宫
+  bool loadFromPacked(std::span<const std::uint8_t> packed);
+
+  // 存档读写（压缩格式）
+  bool saveToFile(const std::string &path) const { return MazeCodec::saveToFile(path, m_packedData); }
+  bool loadFromFile(const std::string &path);
+
   // 生成随机迷宫（使用 MazeGenerator）
   void generateRandomMaze(int width, int height, unsigned int seed = 0, int enemyCount = 8, bool multiplayerMode = false, bool escapeMode = false);
 
-  // 获取迷宫数据（用于网络传输）
-  std::vector<std::string> getMazeData() const { return m_mazeData; }
+  // 获取压缩格式的迷宫数据（用于网络传输和存档）
+  const std::vector<std::uint8_t> &getPackedData() const { return m_packedData; }
 
-  void update(float dt);
+  // 处理受伤墙体的重新着色（只处理脏格子，视图外的留到进入视野再处理）
+  void update(float dt, const sf::View &view);
+  // 使用窗口当前视图裁剪，只绘制可见分块
   void draw(sf::RenderWindow &window) const;
   void render(sf::RenderWindow &window) const { draw(window); } // 别名
 
+  // 视图覆盖的格子范围（外扩 margin 格，已夹到地图内）
+  TileRange getVisibleTiles(const sf::View &view, int margin = 1) const;
+
   // 碰撞检测
   bool checkCollision(sf::Vector2f position, float radius) const;
 
@@ -125,19 +123,17 @@ public:
   // 获取单元格大小
   float getTileSize() const { return m_tileSize; }
 
-  // A* 寻路：返回从 start 到 target 的路径（世界坐标点列表）
-  std::vector<sf::Vector2f> findPath(sf::Vector2f start, sf::Vector2f target) const;
+  // 共享流场：同一目标格子、同一代价的请求共用一个场，目标换格子或地图变化时才重建
+  // 流场同时包含开放路径和穿墙路径（可破坏墙代价为 destructibleCost）
+  // 调用方可以持有返回的流场沿路径前进，但需用 getGoal / getTileVersion 确认它仍对应自己的目标和当前地图
+  std::shared_ptr<const FlowField> getFlowField(sf::Vector2f target, float destructibleCost) const;
 
-  // A* 寻路（考虑可破坏墙）：将可破坏墙视为可通行但代价较高
-  // 返回路径和路径上第一个可破坏墙的位置（如果有）
-  struct PathResult
-  {
-    std::vector<sf::Vector2f> path;
-    bool hasDestructibleWall = false;
-    sf::Vector2f firstDestructibleWallPos = {0, 0};
-    GridPos firstDestructibleWallGrid = {-1, -1};
-  };
-  PathResult findPathThroughDestructible(sf::Vector2f start, sf::Vector2f target, float destructibleCost = 3.0f) const;
+  // 格子类型的版本号（加载/放置/摧毁墙体时递增）
+  std::uint32_t getTileVersion() const { return m_tileVersion; }
+
+  // 格子索引与网格坐标互转（流场使用格子索引），越界返回 -1
+  int gridToIndex(GridPos grid) const { return inBounds(grid.y, grid.x) ? tileIndex(grid.y, grid.x) : -1; }
+  GridPos indexToGrid(int tile) const { return {tile % m_cols, tile / m_cols}; }
 
   // 检查某个格子是否是可破坏墙
   bool isDestructibleWall(int row, int col) const;
@@ -154,13 +150,25 @@ public:
   // 网格坐标转世界坐标（返回格子中心）
   sf::Vector2f gridToWorld(GridPos grid) const;
 
+  // 射线检测结果
+  struct RayHit
+  {
+    WallType type = WallType::None; // None 表示没有阻挡
+    GridPos cell = {-1, -1};         // 阻挡的格子
+    sf::Vector2f point = {0, 0};     // 线段进入该格子的位置
+  };
+
+  // DDA 网格遍历（Amanatides-Woo）：按顺序访问线段 start->end 穿过的每个格子
+  // 返回第一个阻挡的墙；throughDestructible 为 true 时穿过可破坏墙继续寻找不可破坏墙，
+  // 找不到才返回第一个可破坏墙
+  RayHit raycast(sf::Vector2f start, sf::Vector2f end, bool throughDestructible = false) const;
+
   // 视线检测：检查从 start 到 end 是否有清晰视线
   // 返回值：0 = 无阻挡, 1 = 有可拆墙阻挡, 2 = 有不可拆墙阻挡
   int checkLineOfSight(sf::Vector2f start, sf::Vector2f end) const;
 
   // 精确射击检测：检查子弹从 start 射向 target 是否能命中
   // 返回值：0 = 可以命中, 1 = 会先命中可破坏墙, 2 = 会先命中不可破坏墙
-  // 这个函数使用更细的步进来模拟子弹轨迹
   int checkBulletPath(sf::Vector2f start, sf::Vector2f target) const;
 
   // 获取视线方向上第一个被阻挡的位置（用于判断是否应该攻击可拆墙）
@@ -173,14 +181,64 @@ public:
   bool placeWall(sf::Vector2f worldPos);
 
 private:
+  // 格子索引（row * cols + col）
+  int tileIndex(int row, int col) const { return row * m_cols + col; }
+  bool inBounds(int row, int col) const { return row >= 0 && row < m_rows && col >= 0 && col < m_cols; }
+
+  // 根据格子状态计算渲染颜色
+  sf::Color tileFillColor(int idx) const;
+  sf::Color tileOutlineColor(int idx) const;
+
+  // 把格子当前状态写入渲染层（空地则移除）
+  void refreshTile(int row, int col);
+
+  // 标记格子颜色需要刷新（受伤时调用）
+  void markDirty(int idx);
+
   // 检查某个格子是否是墙（用于圆角计算）
   bool isWall(int row, int col) const;
 
-  // 计算所有墙体的圆角
+  // 8 邻居墙体掩码（bit0=上，顺时针）
+  std::uint8_t neighborMask(int row, int col) const;
+
+  // 查表更新单个格子的圆角，有变化时重新烘焙
+  void updateTileCorners(int row, int col);
+
+  // 更新格子及其 8 个邻居的圆角（放置/摧毁墙体后调用）
+  void updateCornersAround(int row, int col);
+
+  // 计算所有墙体的圆角（仅加载时使用）
   void calculateRoundedCorners();
 
-  std::vector<std::vector<Wall>> m_walls;
-  std::vector<std::string> m_mazeData; // 保存原始迷宫数据用于网络传输
+  // 摧毁墙体：清空格子并更新邻居圆角
+  void destroyTile(int row, int col);
+
+  // 格子模拟状态：按字段连续存放，下标为 tileIndex(row, col)
+  std::vector<WallType> m_tileType;
+  std::vector<WallAttribute> m_tileAttribute;
+  std::vector<float> m_tileHealth;
+  std::vector<std::uint8_t> m_tileCorners; // 圆角掩码 bit0..3 = [左上, 右上, 右下, 左下]
+
+  // 流场缓存：每个仍被请求的目标一个
+  // 地图变化后或超过 FLOW_FIELD_TTL 没人请求（目标已换格子或已不存在）的条目可被其他目标复用
+  struct FlowFieldEntry
+  {
+    std::uint32_t tileVersion = 0;
+    std::chrono::steady_clock::time_point lastUse;
+    std::shared_ptr<FlowField> field;
+  };
+  static constexpr auto FLOW_FIELD_TTL = std::chrono::seconds(1); // 敌人每 0.5 秒重新规划一次
+  mutable std::vector<FlowFieldEntry> m_flowFields;
+  std::uint32_t m_tileVersion = 0; // 格子类型变化（加载/放置/摧毁）时递增
+
+  // 批量渲染层（所有墙体一次绘制）
+  MazeRenderer m_renderer;
+
+  // 待重新着色的格子（由伤害事件加入，update 中消费）
+  std::vector<int> m_dirtyTiles;
+  std::vector<std::uint8_t> m_tileDirty; // 去重标记
+
+  std::vector<std::uint8_t> m_packedData; // 加载时的迷宫数据（压缩格式），用于网络传输和存档
   sf::Vector2f m_startPosition;
   sf::Vector2f m_exitPosition;
   std::vector<sf::Vector2f> m_enemySpawnPoints;
@@ -191,12 +249,12 @@ private:
   int m_cols = 0;
   float m_tileSize = TILE_SIZE;
 
-  // 颜色
-  const sf::Color m_solidColor = sf::Color(80, 80, 80);
-  const sf::Color m_destructibleColor = sf::Color(139, 90, 43);
-  const sf::Color m_destructibleDamagedColor = sf::Color(100, 60, 30);
-  const sf::Color m_exitColor = sf::Color(0, 200, 0, 180);
+  // 颜色（静态常量，Maze 才能整体移动赋值，用于换入预生成的迷宫）
+  static constexpr sf::Color m_solidColor = sf::Color(80, 80, 80);
+  static constexpr sf::Color m_destructibleColor = sf::Color(139, 90, 43);
+  static constexpr sf::Color m_destructibleDamagedColor = sf::Color(100, 60, 30);
+  static constexpr sf::Color m_exitColor = sf::Color(0, 200, 0, 180);
   // 属性墙颜色（纯色，无棕色）
-  const sf::Color m_goldWallColor = sf::Color(255, 200, 50); // 明亮金色
-  const sf::Color m_healWallColor = sf::Color(80, 180, 255); // 明亮蓝色
+  static constexpr sf::Color m_goldWallColor = sf::Color(255, 200, 50); // 明亮金色
+  static constexpr sf::Color m_healWallColor = sf::Color(80, 180, 255); // 明亮蓝色
 };
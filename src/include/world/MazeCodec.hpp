@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// 迷宫的压缩二进制格式（网络传输和存档共用）
+// 头部：版本(1) + 列数(2) + 行数(2) + 起点/出口/出生点1/出生点2 的格子坐标(各 2+2，NO_POS 表示没有)
+// 之后是按行的半字节流（高半字节在前），每个格子 4 位，行内做游程编码：
+//   0..Tile::Count-1 = 一个格子；RUN + k = 把前一个格子再重复 k + 2 次
+// 游程不跨行，行尾不需要长度；最后一个字节的低半字节可能是填充
+// 'S' '1' '2' 只记在头部（格子本身是空地），其余字符都有对应的格子编码
+namespace MazeCodec
+{
+  enum class Tile : std::uint8_t
+  {
+    Path,         // '.' 以及 'S' '1' '2' 和未知字符
+    Solid,        // '#'
+    Destructible, // '*'
+    Gold,         // 'G'
+    Heal,         // 'H'
+    Exit,         // 'E'
+    Enemy,        // 'X'
+    Count
+  };
+
+  constexpr std::uint8_t VERSION = 1;
+  constexpr std::size_t HEADER_SIZE = 21;
+  constexpr std::uint16_t NO_POS = 0xFFFF;
+  constexpr std::uint8_t RUN = 0xF;      // 游程标记半字节
+  constexpr int MIN_RUN = 2;             // 游程标记表示的最少重复次数
+  constexpr int MAX_RUN = MIN_RUN + 0xF; // 一个游程标记最多重复的次数
+
+  // 格子坐标（x = 列，y = 行）
+  struct Cell
+  {
+    std::uint16_t x = NO_POS;
+    std::uint16_t y = NO_POS;
+    bool valid() const { return x != NO_POS && y != NO_POS; }
+  };
+
+  struct Header
+  {
+    int cols = 0;
+    int rows = 0;
+    Cell start;
+    Cell exit;
+    Cell spawn1;
+    Cell spawn2;
+  };
+
+  // 连续相同格子的一段（同一行内）
+  struct Run
+  {
+    Tile tile = Tile::Path;
+    int row = 0;
+    int col = 0;
+    int length = 0;
+  };
+
+  Tile tileFromChar(char c);
+
+  // 把字符串地图编码后追加到 out（行长度不一致时按最长行补空地）
+  void encode(const std::vector<std::string> &map, std::vector<std::uint8_t> &out);
+
+  // 只解析头部，数据太短或版本不符时返回 false
+  bool readHeader(std::span<const std::uint8_t> data, Header &out);
+
+  // 完整检查一遍数据（头部和所有行），不做任何分配
+  bool validate(std::span<const std::uint8_t> data, Header &out);
+
+  // 统计某种格子的数量（例如敌人数），数据无效时返回 0
+  int countTiles(std::span<const std::uint8_t> data, Tile tile);
+
+  // 按行优先顺序逐段读出格子，直接在原始字节上解码（不复制数据）
+  class RunReader
+  {
+  public:
+    // data 必须已通过 readHeader / validate
+    RunReader(std::span<const std::uint8_t> data, const Header &header);
+
+    // 读出下一段，全部读完或数据损坏时返回 false（用 ok() 区分）
+    bool next(Run &out);
+
+    // 是否完整读完所有行且没有错误
+    bool ok() const { return !m_error && m_row >= m_rows; }
+
+  private:
+    int readNibble();
+
+    std::span<const std::uint8_t> m_data;
+    std::size_t m_nibble = 0;
+    std::size_t m_nibbleEnd = 0;
+    int m_rows = 0;
+    int m_cols = 0;
+    int m_row = 0;
+    int m_col = 0;
+    int m_prevTile = -1; // 本行上一个格子，行首为 -1
+    bool m_error = false;
+  };
+
+  // 存档：文件魔数 + 压缩数据
+  bool saveToFile(const std::string &path, std::span<const std::uint8_t> packed);
+  bool loadFromFile(const std::string &path, std::vector<std::uint8_t> &outPacked);
+}
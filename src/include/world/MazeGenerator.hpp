@@ -1,8 +1,72 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <string>
-#include <random>
+#include <utility>
+
+// 迷宫生成专用的随机数发生器（PCG32）和洗牌
+// 不使用 std::shuffle / 标准库分布（其结果依赖实现），同一种子在任何平台和编译器上生成相同的迷宫
+class MazeRandom
+{
+public:
+  void seed(std::uint64_t value)
+  {
+    m_state = 0;
+    next();
+    m_state += value;
+    next();
+  }
+
+  std::uint32_t next()
+  {
+    const std::uint64_t old = m_state;
+    m_state = old * 6364136223846793005ULL + INCREMENT;
+    const auto xorshifted = static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+    const auto rot = static_cast<std::uint32_t>(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+  }
+
+  // [0, bound) 内的均匀整数（拒绝采样，无偏）
+  std::uint32_t below(std::uint32_t bound)
+  {
+    const std::uint32_t threshold = (0u - bound) % bound;
+    while (true)
+    {
+      const std::uint32_t r = next();
+      if (r >= threshold)
+        return r % bound;
+    }
+  }
+
+  // Fisher-Yates 洗牌（vector 或 array）
+  template <typename Container>
+  void shuffle(Container &items)
+  {
+    for (std::size_t i = items.size(); i > 1; --i)
+    {
+      const std::size_t j = below(static_cast<std::uint32_t>(i));
+      std::swap(items[i - 1], items[j]);
+    }
+  }
+
+private:
+  static constexpr std::uint64_t INCREMENT = 1442695040888963407ULL;
+  std::uint64_t m_state = 0;
+};
+
+// 联机同步用的迷宫参数：两端用同样的参数生成完全相同的迷宫，只需传输这几个数
+struct MazeRecipe
+{
+  std::uint32_t seed = 1; // 非 0
+  int width = 0;
+  int height = 0;
+  int enemyCount = 0;
+  bool multiplayerMode = true;
+  bool escapeMode = false;
+};
 
 class MazeGenerator
 {
@@ -12,9 +76,24 @@ public:
   // 生成随机迷宫
   std::vector<std::string> generate();
 
+  // 按参数生成（联机两端调用同一个函数，保证参数设置一致）
+  static std::vector<std::string> generateFromRecipe(const MazeRecipe &recipe);
+
+  // 大厅提供的迷宫尺寸和敌人数范围，网络传来的参数超出时不生成
+  static constexpr int MIN_MAZE_SIZE = 15;
+  static constexpr int MAX_MAZE_SIZE = 151;
+  static constexpr int MAX_ENEMY_COUNT = 100;
+  static bool isValidRecipe(const MazeRecipe &recipe);
+
+  // 迷宫内容的校验和（FNV-1a），用于确认两端生成结果一致
+  static std::uint32_t checksum(const std::vector<std::string> &mazeData);
+
   // 设置随机种子
   void setSeed(unsigned int seed);
 
+  // 上一次生成使用的种子（未设置种子时为按时间选取的种子）
+  unsigned int getSeed() const { return m_seed; }
+
   // 设置敌人数量
   void setEnemyCount(int count) { m_enemyCount = count; }
 
@@ -32,7 +111,7 @@ public:
   std::pair<int, int> getSpawn2() const { return {m_spawn2X, m_spawn2Y}; }
 
 private:
-  void carvePassage(int x, int y);
+  void carvePassage(int startX, int startY);
   void placeEnemies();
   void placeDestructibleWalls();
   void placeStartAndEnd();                                     // 随机放置起点和终点
@@ -40,10 +119,39 @@ private:
   void ensurePath(int startX, int startY, int endX, int endY); // 确保起点到终点有路径
   std::vector<std::pair<int, int>> getEmptySpaces();           // 获取所有空地
 
+  // 网格分析（所有放置步骤共用）：可通行 = 内部且不是 '#'
+  bool isOpen(int x, int y) const { return x > 0 && x < m_width - 1 && y > 0 && y < m_height - 1 && m_grid[index(x, y)] != '#'; }
+  // BFS 距离图：outDistance[index] 为从 (startX, startY) 出发的步数，-1 表示不可达
+  // maxDistance >= 0 时只搜索到该步数为止，更远的格子也记为 -1
+  void computeDistances(int startX, int startY, std::vector<int> &outDistance, int maxDistance = -1);
+  // 连通分量标记（一次扫描），结果写入 m_component，挖墙后需重新标记
+  void labelComponents();
+
+  // 行优先的平铺网格
+  int index(int x, int y) const { return y * m_width + x; }
+  char &cell(int x, int y) { return m_grid[index(x, y)]; }
+
+  // 挖通道的显式栈帧：格子坐标、打乱后的方向和下一个要尝试的方向
+  struct CarveFrame
+  {
+    int x = 0;
+    int y = 0;
+    std::array<std::uint8_t, 4> dirs = {0, 1, 2, 3};
+    std::uint8_t next = 0;
+  };
+
   int m_width;
   int m_height;
-  std::vector<std::vector<char>> m_grid;
-  std::mt19937 m_rng;
+  std::vector<char> m_grid;
+  std::vector<CarveFrame> m_carveStack; // 生成之间复用
+
+  // 网格分析缓冲（生成之间复用）
+  std::vector<int> m_bfsQueue;  // BFS 队列，每个格子最多入队一次，容量固定为格子数
+  std::vector<int> m_distanceA; // 距离图（起点 / 出生点1）
+  std::vector<int> m_distanceB; // 距离图（出生点2）
+  std::vector<int> m_component; // 连通分量编号，墙为 -1
+  bool m_componentsValid = false;
+  MazeRandom m_rng;
   unsigned int m_seed = 0;
   bool m_seedSet = false;
 
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Maze.hpp"
+
+// 预生成好的迷宫：已解析到格子数组并烘焙好墙体几何，开局时直接换入
+struct PreparedMaze
+{
+  Maze maze;
+  MazeRecipe recipe;          // 实际使用的参数（含种子）
+  std::uint32_t checksum = 0; // MazeGenerator::checksum，联机同步种子时使用
+};
+
+// 后台迷宫预生成池
+// 工作线程按当前设置（尺寸、敌人数、模式）保持若干个准备好的迷宫；设置改变时丢弃旧的重新生成
+class MazePool
+{
+public:
+  MazePool(std::size_t workerCount, std::size_t readyTarget);
+  ~MazePool();
+
+  MazePool(const MazePool &) = delete;
+  MazePool &operator=(const MazePool &) = delete;
+
+  // 设置要预生成的迷宫参数（seed 不参与比较，由池随机选取）；与当前设置相同时什么都不做
+  void configure(const MazeRecipe &settings);
+
+  // 取出一个按 settings 生成好的迷宫并让工作线程补上
+  // 没有现成的时返回 nullptr（调用方同步生成），同时把池切换到 settings
+  std::unique_ptr<PreparedMaze> tryTake(const MazeRecipe &settings);
+
+private:
+  void workerLoop();
+  static bool sameSettings(const MazeRecipe &a, const MazeRecipe &b);
+
+  // 以下成员由 m_mutex 保护
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::deque<std::unique_ptr<PreparedMaze>> m_ready;
+  MazeRecipe m_settings;
+  bool m_configured = false;
+  std::uint32_t m_generation = 0; // 设置版本，生成期间设置改变则丢弃结果
+  std::size_t m_inFlight = 0;     // 正在生成的数量
+  bool m_stopping = false;
+
+  const std::size_t m_readyTarget;
+  std::vector<std::thread> m_workers;
+};
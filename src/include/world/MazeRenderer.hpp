@@ -0,0 +1,91 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 格子范围（行列闭区间）
+struct TileRange
+{
+  int minRow = 0;
+  int minCol = 0;
+  int maxRow = -1;
+  int maxCol = -1;
+};
+
+// 迷宫墙体批量渲染层
+// 墙体（包括选择性圆角和描边）按 CHUNK_SIZE x CHUNK_SIZE 分块烘焙进顶点缓冲，每块一次 draw 调用
+// 每个墙格的顶点槽按其圆角组合的实际点数分配，格子变化时只改写并上传对应的槽
+// 顶点先写在内存中（可在后台线程构建），显存缓冲在主线程首次绘制时创建
+class MazeRenderer
+{
+public:
+  MazeRenderer();
+
+  // 加载新迷宫时调用，清空所有墙格
+  void reset(int rows, int cols, float tileSize, float cornerRadius);
+
+  // 写入一个墙格的几何和颜色
+  // cornerMask: bit0..3 = [左上, 右上, 右下, 左下] 是否为圆角
+  void setTile(int row, int col, std::uint8_t cornerMask, sf::Color fill, sf::Color outline, float outlineThickness);
+
+  // 只修改墙格的填充颜色（几何不变）
+  void setTileFill(int row, int col, sf::Color fill);
+
+  // 移除墙格（顶点退化为零面积三角形）
+  void clearTile(int row, int col);
+
+  // 只绘制与可见范围相交的分块（先上传这些分块中改动过的顶点）
+  void draw(sf::RenderTarget &target, const TileRange &visible) const;
+
+private:
+  // 分块边长（格子数）
+  static constexpr int CHUNK_SIZE = 16;
+
+  // 每个圆角的采样点数，与原来的 SelectiveRoundedRectShape 保持一致
+  static constexpr unsigned int CORNER_POINTS = 6;
+  static constexpr std::size_t MAX_POINTS = 4 * CORNER_POINTS;
+  static constexpr std::size_t MAX_FILL_VERTS = (MAX_POINTS - 2) * 3; // 扇形三角化
+  static constexpr std::size_t MAX_OUTLINE_VERTS = MAX_POINTS * 6;    // 每条边一个四边形
+
+  // 某种圆角组合的局部几何（相对格子左上角），直角格子只有 4 个点
+  struct TileTemplate
+  {
+    std::array<sf::Vector2f, MAX_FILL_VERTS> fill;
+    std::array<sf::Vector2f, MAX_OUTLINE_VERTS> outlineBase;   // 描边内侧点
+    std::array<sf::Vector2f, MAX_OUTLINE_VERTS> outlineNormal; // 外扩方向（乘以描边厚度）
+    std::size_t fillCount = 0;
+    std::size_t outlineCount = 0;
+  };
+
+  // 一个分块：内存中的顶点和对应的显存缓冲
+  struct Chunk
+  {
+    std::vector<sf::Vertex> vertices;
+    mutable std::unique_ptr<sf::VertexBuffer> buffer; // 首次绘制时创建
+    mutable std::size_t dirtyBegin = 0;               // [dirtyBegin, dirtyEnd) 尚未上传
+    mutable std::size_t dirtyEnd = 0;
+  };
+
+  void buildTemplates(float tileSize, float cornerRadius);
+
+  Chunk &chunkAt(int row, int col);
+  static void markDirty(Chunk &chunk, std::size_t first, std::size_t count);
+  // 把格子的 [first, 槽容量) 顶点收缩到格子左上角
+  void collapseSlot(Chunk &chunk, int row, int col, std::size_t first);
+  // 上传分块中改动过的顶点，缓冲不够大时重建；失败返回 false
+  static bool upload(const Chunk &chunk);
+
+  std::array<TileTemplate, 16> m_templates;
+  std::vector<Chunk> m_chunks;              // 行优先排列的分块
+  std::vector<int> m_tileSlot;              // 格子 -> 所属分块内顶点槽的首个顶点，-1 表示没有
+  std::vector<std::uint16_t> m_tileCapacity; // 格子顶点槽的长度
+  std::vector<std::uint8_t> m_tileMask;     // 格子当前的圆角组合
+  int m_rows = 0;
+  int m_cols = 0;
+  int m_chunkRows = 0;
+  int m_chunkCols = 0;
+  float m_tileSize = 60.f;
+};
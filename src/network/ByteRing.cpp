@@ -0,0 +1,58 @@
+#include "ByteRing.hpp"
+#include <algorithm>
+#include <cstring>
+
+ByteRing::ByteRing(std::size_t initialCapacity)
+    : m_buffer(std::max<std::size_t>(initialCapacity, 16))
+{
+}
+
+void ByteRing::write(const std::uint8_t *data, std::size_t size)
+{
+  if (m_size + size > m_buffer.size())
+    grow(m_size + size);
+
+  // 尾部可能跨越末尾，分两段拷贝
+  const std::size_t capacity = m_buffer.size();
+  const std::size_t tail = (m_head + m_size) % capacity;
+  const std::size_t first = std::min(size, capacity - tail);
+  std::memcpy(m_buffer.data() + tail, data, first);
+  std::memcpy(m_buffer.data(), data + first, size - first);
+  m_size += size;
+}
+
+std::span<const std::uint8_t> ByteRing::front() const
+{
+  const std::size_t length = std::min(m_size, m_buffer.size() - m_head);
+  return {m_buffer.data() + m_head, length};
+}
+
+void ByteRing::consume(std::size_t size)
+{
+  size = std::min(size, m_size);
+  m_head = (m_head + size) % m_buffer.size();
+  m_size -= size;
+  if (m_size == 0)
+    m_head = 0; // 清空时回到开头，之后的写入尽量保持连续
+}
+
+void ByteRing::clear()
+{
+  m_head = 0;
+  m_size = 0;
+}
+
+void ByteRing::grow(std::size_t minCapacity)
+{
+  std::size_t capacity = m_buffer.size();
+  while (capacity < minCapacity)
+    capacity *= 2;
+
+  // 扩容时把数据整理到新缓冲区开头
+  std::vector<std::uint8_t> buffer(capacity);
+  const std::size_t first = std::min(m_size, m_buffer.size() - m_head);
+  std::memcpy(buffer.data(), m_buffer.data() + m_head, first);
+  std::memcpy(buffer.data() + first, m_buffer.data(), m_size - first);
+  m_buffer.swap(buffer);
+  m_head = 0;
+}
@@ -3,6 +3,7 @@
 #include "CollisionSystem.hpp"
 #include "Utils.hpp"
 #include "AudioManager.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <limits>
@@ -161,45 +162,20 @@ void MultiplayerHandler::update(
   // 如果本地玩家没死，正常更新
   if (!state.localPlayerDead)
   {
-    // 保存旧位置
-    sf::Vector2f oldPos = ctx.player->getPosition();
-    sf::Vector2f movement = ctx.player->getMovement(dt);
-
-    // 更新本地玩家
-    ctx.player->update(dt, mouseWorldPos);
-
-    // 碰撞检测
-    sf::Vector2f newPos = ctx.player->getPosition();
-    float radius = ctx.player->getCollisionRadius();
-
-    if (ctx.maze.checkCollision(newPos, radius))
+    // 更新本地玩家：射击计时，然后按本帧输入移动（非房主记录输入，用于房主纠正后回放）
+    ctx.player->updateShooting(dt);
+    InputCommand input;
+    if (state.isHost)
     {
-      sf::Vector2f posX = {oldPos.x + movement.x, oldPos.y};
-      sf::Vector2f posY = {oldPos.x, oldPos.y + movement.y};
-
-      bool canMoveX = !ctx.maze.checkCollision(posX, radius);
-      bool canMoveY = !ctx.maze.checkCollision(posY, radius);
-
-      if (canMoveX && canMoveY)
-      {
-        if (std::abs(movement.x) > std::abs(movement.y))
-          ctx.player->setPosition(posX);
-        else
-          ctx.player->setPosition(posY);
-      }
-      else if (canMoveX)
-      {
-        ctx.player->setPosition(posX);
-      }
-      else if (canMoveY)
-      {
-        ctx.player->setPosition(posY);
-      }
-      else
-      {
-        ctx.player->setPosition(oldPos);
-      }
+      input.keys = ctx.player->getMoveKeys();
+      input.dt = dt;
+      input.aim = mouseWorldPos;
     }
+    else
+    {
+      input = state.inputHistory.record(ctx.player->getMoveKeys(), dt, mouseWorldPos);
+    }
+    stepTank(*ctx.player, ctx.maze, input);
 
     // 处理射击（只有活着的玩家可以射击）
     if (ctx.player->hasFiredBullet())
@@ -338,6 +314,12 @@ void MultiplayerHandler::update(
     }
   }
 
+  // 网络节拍：位置和NPC快照按固定频率发送，不随渲染帧率变化
+  state.networkTick = net.advanceTick(dt);
+
+  // 远端坦克和NPC显示插值后的状态
+  applyRemoteSnapshots(ctx, state);
+
   // 更新NPC AI（仅房主执行）
   // 非房主的NPC位置通过网络回调直接设置，不需要本地更新
   if (state.isHost)
@@ -345,19 +327,37 @@ void MultiplayerHandler::update(
     updateNpcAI(ctx, state, dt);
   }
 
-  // 发送位置到服务器
-  PlayerState pstate;
-  pstate.x = ctx.player->getPosition().x;
-  pstate.y = ctx.player->getPosition().y;
-  pstate.rotation = ctx.player->getRotation();
-  pstate.turretAngle = ctx.player->getTurretRotation();
-  pstate.health = ctx.player->getHealth();
-  pstate.reachedExit = state.localPlayerReachedExit;
-  pstate.isDead = state.localPlayerDead;
-  net.sendPosition(pstate);
+  // 节拍边界时同步预测：非房主发送最近的输入，房主发回对方坦克的权威位置
+  if (state.networkTick)
+  {
+    if (!state.isHost && !state.inputHistory.empty())
+    {
+      state.inputHistory.recent(state.inputScratch);
+      net.sendPlayerInput(state.inputScratch);
+    }
+    if (state.isHost && state.guestAuthority.isActive() && state.guestAuthority.takeCorrection())
+    {
+      const Tank &guest = state.guestAuthority.getTank();
+      net.sendPlayerCorrection(state.guestAuthority.getLastInput(), guest.getPosition(), guest.getRotation());
+    }
+  }
 
-  // 更新迷宫
-  ctx.maze.update(dt);
+  // 节拍边界时发送位置到服务器
+  if (state.networkTick)
+  {
+    PlayerState pstate;
+    pstate.x = ctx.player->getPosition().x;
+    pstate.y = ctx.player->getPosition().y;
+    pstate.rotation = ctx.player->getRotation();
+    pstate.turretAngle = ctx.player->getTurretRotation();
+    pstate.health = ctx.player->getHealth();
+    pstate.reachedExit = state.localPlayerReachedExit;
+    pstate.isDead = state.localPlayerDead;
+    net.sendPosition(pstate);
+  }
+
+  // 更新迷宫（只处理镜头附近的格子）
+  ctx.maze.update(dt, ctx.gameView);
 
   // 更新子弹
   for (auto &bullet : ctx.bullets)
@@ -533,12 +533,48 @@ void MultiplayerHandler::handleNpcActivation(
   state.rKeyJustPressed = false;
 }
 
+void MultiplayerHandler::applyRemoteSnapshots(
+    MultiplayerContext &ctx,
+    MultiplayerState &state)
+{
+  if (!state.remoteClock.isValid())
+    return;
+
+  const double renderTime = state.remoteClock.renderTime(std::chrono::steady_clock::now(),
+                                                         NetworkManager::getInstance().getTickInterval());
+  EntitySnapshot snapshot;
+
+  if (ctx.otherPlayer && state.otherPlayerSnapshots.sample(renderTime, snapshot))
+  {
+    ctx.otherPlayer->setPosition(snapshot.position);
+    ctx.otherPlayer->setRotation(snapshot.rotation);
+    ctx.otherPlayer->setTurretRotation(snapshot.turretAngle);
+  }
+
+  // 房主的NPC由本地AI驱动
+  if (state.isHost)
+    return;
+
+  const std::size_t count = std::min(state.npcSnapshots.size(), ctx.enemies.size());
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    auto &npc = ctx.enemies[i];
+    if (npc->isDead() || !state.npcSnapshots[i].sample(renderTime, snapshot))
+      continue;
+
+    npc->setPosition(snapshot.position);
+    npc->setRotation(snapshot.rotation);
+    npc->setTurretRotation(snapshot.turretAngle);
+  }
+}
+
 void MultiplayerHandler::updateNpcAI(
     MultiplayerContext &ctx,
     MultiplayerState &state,
     float dt)
 {
   auto &net = NetworkManager::getInstance();
+  std::vector<NpcState> npcStates; // 本帧所有NPC的状态，最后作为一个快照发送
 
   for (size_t i = 0; i < ctx.enemies.size(); ++i)
   {
@@ -653,7 +689,6 @@ void MultiplayerHandler::updateNpcAI(
           AudioManager::getInstance().playSFX(SFXType::Shoot, bulletPos, ctx.player->getPosition());
         }
 
-        // 每帧同步NPC状态
         NpcState npcState;
         npcState.id = static_cast<int>(i);
         npcState.x = npc->getPosition().x;
@@ -663,10 +698,16 @@ void MultiplayerHandler::updateNpcAI(
         npcState.health = npc->getHealth();
         npcState.team = npc->getTeam();
         npcState.activated = npc->isActivated();
-        net.sendNpcUpdate(npcState);
+        npcStates.push_back(npcState);
       }
     }
   }
+
+  // 节拍边界时同步NPC状态（只发送相对已确认快照的变化；发送队列积压时跳过，下一个快照会覆盖）
+  if (state.isHost && state.networkTick && !npcStates.empty() && !net.isSendBackedUp())
+  {
+    net.sendNpcSnapshot(npcStates);
+  }
 }
 
 void MultiplayerHandler::renderConnecting(
@@ -1,5 +1,11 @@
 #include "NetworkManager.hpp"
+#include "MazeCodec.hpp"
+#include "Prediction.hpp"
+#include "Utils.hpp"
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstring>
 
 NetworkManager &NetworkManager::getInstance()
@@ -10,6 +16,8 @@ NetworkManager &NetworkManager::getInstance()
 
 bool NetworkManager::connect(const std::string &host, unsigned short port)
 {
+  stopNetworkThread();
+
   m_socket.setBlocking(true);
   auto address = sf::IpAddress::resolve(host);
   if (!address.has_value())
@@ -34,6 +42,20 @@ bool NetworkManager::connect(const std::string &host, unsigned short port)
   }
 
   m_connected = true;
+  resetBuffers();
+
+  // UDP 通道：绑定任意端口，等 ConnectAck 分配会话ID后启用
+  m_serverAddress = address;
+  m_serverPort = port;
+  m_udpBound = m_udpSocket.bind(sf::Socket::AnyPort) == sf::Socket::Status::Done;
+  m_udpSocket.setBlocking(false);
+  m_udpReady = false;
+  m_udpEchoed = false;
+  m_udpRegisterAttempts = 0;
+  m_sessionId = 0;
+  m_udpSequence = 0;
+
+  startNetworkThread();
 
   // 发送连接消息
   std::vector<uint8_t> data;
@@ -55,12 +77,17 @@ void NetworkManager::disconnect()
     std::vector<uint8_t> data;
     data.push_back(static_cast<uint8_t>(NetMessageType::Disconnect));
     sendPacket(data);
+    flush(); // 网络线程退出前会尽量把剩余数据（包括断开消息）发出去
   }
 
+  stopNetworkThread();
   m_socket.disconnect();
+  m_udpSocket.unbind();
+  m_udpBound = false;
+  m_udpReady = false;
   m_connected = false;
   m_roomCode.clear();
-  m_receiveBuffer.clear();
+  resetBuffers();
 
   if (m_onDisconnected)
   {
@@ -68,6 +95,60 @@ void NetworkManager::disconnect()
   }
 }
 
+void NetworkManager::startNetworkThread()
+{
+  m_socketClosed = false;
+  m_running = true;
+  m_selector.clear();
+  m_selector.add(m_socket);
+  if (m_udpBound)
+    m_selector.add(m_udpSocket);
+  m_udpLastSequence.clear();
+  m_thread = std::thread(&NetworkManager::networkThreadLoop, this);
+}
+
+void NetworkManager::stopNetworkThread()
+{
+  m_running = false;
+  if (m_thread.joinable())
+  {
+    m_thread.join();
+  }
+  m_selector.clear();
+}
+
+void NetworkManager::resetBuffers()
+{
+  InboundChunk chunk;
+  while (m_inbound.pop(chunk))
+  {
+  }
+  std::vector<uint8_t> buffer;
+  while (m_outbound.pop(buffer))
+  {
+  }
+  while (m_udpOutbound.pop(buffer))
+  {
+  }
+  m_datagram.clear();
+
+  m_receiveStart = 0;
+  m_receiveEnd = 0;
+  m_sendQueue.clear();
+  m_queuedBytes = 0;
+  m_batch.clear();
+  m_batchCount = 0;
+  m_outgoing.clear();
+  m_outboundOverflow.clear();
+  m_outboundBytes = 0;
+  m_npcSender.reset();
+  m_npcReceiver.reset();
+  m_pendingMaze = {}; // 等待进行中的生成结束并丢弃结果
+  m_deferredMessages.clear();
+  m_tickAccumulator = 0.f;
+  m_tick = 0;
+}
+
 void NetworkManager::createRoom(int mazeWidth, int mazeHeight, bool isDarkMode)
 {
   if (!m_connected)
@@ -109,26 +190,13 @@ void NetworkManager::sendPosition(const PlayerState &state)
   if (!m_connected)
     return;
 
-  std::vector<uint8_t> data;
-  data.push_back(static_cast<uint8_t>(NetMessageType::PlayerUpdate));
-
-  // 添加位置数据 (float -> bytes)
-  auto addFloat = [&data](float value)
-  {
-    uint8_t *bytes = reinterpret_cast<uint8_t *>(&value);
-    for (int i = 0; i < 4; i++)
-      data.push_back(bytes[i]);
-  };
-
-  addFloat(state.x);
-  addFloat(state.y);
-  addFloat(state.rotation);
-  addFloat(state.turretAngle);
-  addFloat(state.health);
-  data.push_back(state.reachedExit ? 1 : 0);
-  data.push_back(state.isDead ? 1 : 0); // 添加死亡状态
-
-  sendPacket(data);
+  // 量化编码到栈上缓冲区：类型(1) + 位打包的状态
+  PlayerState stamped = state;
+  stamped.tick = m_tick;
+  uint8_t data[1 + StateCodec::MAX_STATE_BYTES];
+  data[0] = static_cast<uint8_t>(NetMessageType::PlayerUpdate);
+  std::size_t size = 1 + m_stateCodec.encodePlayer(stamped, data + 1);
+  sendState({data, size});
 }
 
 void NetworkManager::sendShoot(float x, float y, float angle)
@@ -269,7 +337,7 @@ void NetworkManager::sendRescueProgress(float progress)
   for (int i = 0; i < 4; i++)
     data.push_back(bytes[i]);
 
-  sendPacket(data);
+  sendState(data);
 }
 
 void NetworkManager::sendRescueComplete()
@@ -326,34 +394,56 @@ void NetworkManager::sendNpcActivate(int npcId, int team, int activatorId)
   sendPacket(data);
 }
 
-void NetworkManager::sendNpcUpdate(const NpcState &state)
+void NetworkManager::sendNpcSnapshot(std::span<const NpcState> states)
 {
   if (!m_connected)
     return;
 
-  std::vector<uint8_t> data;
-  data.push_back(static_cast<uint8_t>(NetMessageType::NpcUpdate));
-  data.push_back(static_cast<uint8_t>(state.id));
+  m_npcSnapshot.clear();
+  m_npcSnapshot.push_back(static_cast<uint8_t>(NetMessageType::NpcSnapshot));
+  m_npcSender.encode(states, m_tick, m_stateCodec, m_npcSnapshot);
+  sendState(m_npcSnapshot);
+}
 
-  // 位置
-  auto pushFloat = [&data](float f)
+void NetworkManager::sendPlayerInput(std::span<const InputCommand> inputs)
+{
+  if (!m_connected || inputs.empty())
+    return;
+
+  // 只发最新的 MAX_INPUTS_PER_MESSAGE 条；之前的已经发过多次，房主仍未收到时由纠正兜底
+  if (inputs.size() > MAX_INPUTS_PER_MESSAGE)
+    inputs = inputs.last(MAX_INPUTS_PER_MESSAGE);
+
+  uint8_t data[2 + MAX_INPUTS_PER_MESSAGE * 7];
+  std::size_t size = 0;
+  data[size++] = static_cast<uint8_t>(NetMessageType::PlayerInput);
+  data[size++] = static_cast<uint8_t>(inputs.size());
+  for (const InputCommand &input : inputs)
   {
-    uint32_t bits;
-    std::memcpy(&bits, &f, sizeof(float));
-    data.push_back(static_cast<uint8_t>(bits & 0xFF));
-    data.push_back(static_cast<uint8_t>((bits >> 8) & 0xFF));
-    data.push_back(static_cast<uint8_t>((bits >> 16) & 0xFF));
-    data.push_back(static_cast<uint8_t>((bits >> 24) & 0xFF));
-  };
+    for (int i = 0; i < 4; ++i)
+      data[size++] = static_cast<uint8_t>(input.sequence >> (i * 8));
+    data[size++] = input.keys;
+    const auto dt = static_cast<uint16_t>(std::lround(input.dt * INPUT_DT_STEPS_PER_SECOND));
+    data[size++] = static_cast<uint8_t>(dt & 0xFF);
+    data[size++] = static_cast<uint8_t>(dt >> 8);
+  }
+  sendState({data, size});
+}
 
-  pushFloat(state.x);
-  pushFloat(state.y);
-  pushFloat(state.rotation);
-  pushFloat(state.turretAngle);
-  pushFloat(state.health);
-  data.push_back(static_cast<uint8_t>(state.team));
-  data.push_back(state.activated ? 1 : 0);
-  sendPacket(data);
+void NetworkManager::sendPlayerCorrection(uint32_t lastInput, sf::Vector2f position, float rotation)
+{
+  if (!m_connected)
+    return;
+
+  // 位置用原始浮点数：非房主从这里开始回放，量化误差会变成每次纠正的抖动
+  uint8_t data[17];
+  data[0] = static_cast<uint8_t>(NetMessageType::PlayerCorrection);
+  for (int i = 0; i < 4; ++i)
+    data[1 + i] = static_cast<uint8_t>(lastInput >> (i * 8));
+  std::memcpy(data + 5, &position.x, sizeof(float));
+  std::memcpy(data + 9, &position.y, sizeof(float));
+  std::memcpy(data + 13, &rotation, sizeof(float));
+  sendState(data);
 }
 
 void NetworkManager::sendNpcShoot(int npcId, float x, float y, float angle)
@@ -399,111 +489,584 @@ void NetworkManager::sendNpcDamage(int npcId, float damage)
   sendPacket(data);
 }
 
-void NetworkManager::sendMazeData(const std::vector<std::string> &mazeData, bool isEscapeMode, bool isDarkMode)
+void NetworkManager::sendMazeData(std::span<const uint8_t> packedMaze, bool isEscapeMode, bool isDarkMode)
 {
   if (!m_connected)
     return;
 
+  MazeCodec::Header header;
+  if (!MazeCodec::readHeader(packedMaze, header))
+    return;
+
   std::vector<uint8_t> data;
+  data.reserve(3 + packedMaze.size());
   data.push_back(static_cast<uint8_t>(NetMessageType::MazeData));
 
   // 游戏模式标志: bit 0 = isEscapeMode, bit 1 = isDarkMode
   uint8_t modeFlags = (isEscapeMode ? 1 : 0) | (isDarkMode ? 2 : 0);
   data.push_back(modeFlags);
 
-  // 迷宫行数
-  uint16_t rows = static_cast<uint16_t>(mazeData.size());
-  data.push_back(static_cast<uint8_t>(rows & 0xFF));
-  data.push_back(static_cast<uint8_t>((rows >> 8) & 0xFF));
+  // 节拍频率（对方按此频率发送和插值）
+  data.push_back(static_cast<uint8_t>(m_tickRate));
+
+  setMazeSize(header.rows, header.cols);
+
+  // 压缩的迷宫数据（MazeCodec 格式）
+  data.insert(data.end(), packedMaze.begin(), packedMaze.end());
+
+  sendPacket(data);
+}
+
+void NetworkManager::sendMazeSeed(const MazeRecipe &recipe, uint32_t checksum, bool isDarkMode)
+{
+  if (!m_connected)
+    return;
 
-  // 每行数据
-  for (const auto &row : mazeData)
+  uint8_t data[17];
+  data[0] = static_cast<uint8_t>(NetMessageType::MazeSeed);
+  // 模式标志与 MazeData 相同: bit 0 = isEscapeMode, bit 1 = isDarkMode
+  data[1] = static_cast<uint8_t>((recipe.escapeMode ? 1 : 0) | (isDarkMode ? 2 : 0));
+  for (int i = 0; i < 4; ++i)
   {
-    uint16_t len = static_cast<uint16_t>(row.length());
-    data.push_back(static_cast<uint8_t>(len & 0xFF));
-    data.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
-    for (char c : row)
-    {
-      data.push_back(static_cast<uint8_t>(c));
-    }
+    data[2 + i] = static_cast<uint8_t>(recipe.seed >> (i * 8));
+    data[12 + i] = static_cast<uint8_t>(checksum >> (i * 8));
   }
+  data[6] = static_cast<uint8_t>(recipe.width & 0xFF);
+  data[7] = static_cast<uint8_t>((recipe.width >> 8) & 0xFF);
+  data[8] = static_cast<uint8_t>(recipe.height & 0xFF);
+  data[9] = static_cast<uint8_t>((recipe.height >> 8) & 0xFF);
+  data[10] = static_cast<uint8_t>(recipe.enemyCount & 0xFF);
+  data[11] = static_cast<uint8_t>((recipe.enemyCount >> 8) & 0xFF);
+  data[16] = static_cast<uint8_t>(m_tickRate);
+  sendPacket(data);
+}
+
+void NetworkManager::sendRequestMaze()
+{
+  if (!m_connected)
+    return;
 
+  uint8_t data[1] = {static_cast<uint8_t>(NetMessageType::RequestMaze)};
   sendPacket(data);
 }
 
+void NetworkManager::setMazeSize(std::size_t rows, std::size_t cols)
+{
+  m_stateCodec.setWorldSize({static_cast<float>(cols) * TILE_SIZE, static_cast<float>(rows) * TILE_SIZE});
+
+  // 量化范围变了，旧基准不再有效
+  m_npcSender.reset();
+  m_npcReceiver.reset();
+}
+
+void NetworkManager::setTickRate(int ticksPerSecond)
+{
+  m_tickRate = std::clamp(ticksPerSecond, MIN_TICK_RATE, MAX_TICK_RATE);
+}
+
+bool NetworkManager::advanceTick(float dt)
+{
+  m_tickAccumulator += dt;
+  const float interval = getTickInterval();
+  if (m_tickAccumulator < interval)
+    return false;
+
+  // 一帧跨过多个节拍时只发送一次（最新状态），但节拍编号照常前进，保持与时间对应
+  const int elapsed = static_cast<int>(m_tickAccumulator / interval);
+  m_tick += static_cast<uint32_t>(elapsed);
+  m_tickAccumulator -= static_cast<float>(elapsed) * interval;
+  return true;
+}
+
 void NetworkManager::update()
 {
   if (!m_connected)
     return;
 
-  receiveData();
+  finishPendingMaze();
+
+  // 处理网络线程收到的消息
+  InboundChunk chunk;
+  while (m_connected && m_inbound.pop(chunk))
+  {
+    m_receiveTime = chunk.receivedAt;
+    dispatchChunk(chunk.data);
+
+    // 缓冲区送回网络线程复用
+    chunk.data.clear();
+    m_inboundFree.push(std::move(chunk.data));
+  }
+
+  // UDP 登记：收到服务器回显才改走 UDP；之前定期重发登记，超过次数后一直使用 TCP
+  if (m_connected && !m_udpReady && m_sessionId != 0)
+  {
+    if (m_udpEchoed)
+    {
+      m_udpReady = true;
+      std::vector<uint8_t> data;
+      data.push_back(static_cast<uint8_t>(NetMessageType::UdpReady));
+      sendPacket(data);
+    }
+    else if (m_udpRegisterAttempts < MAX_UDP_REGISTER_ATTEMPTS &&
+             std::chrono::steady_clock::now() - m_udpRegisterSentAt >= UDP_REGISTER_INTERVAL)
+    {
+      sendUdpRegistration();
+    }
+  }
+
+  // 网络线程发现连接断开（先处理完断开前收到的消息）
+  if (m_connected && m_socketClosed && m_inbound.empty())
+  {
+    stopNetworkThread();
+    m_connected = false;
+    resetBuffers();
+    if (m_onDisconnected)
+    {
+      m_onDisconnected();
+    }
+  }
 }
 
-void NetworkManager::sendPacket(const std::vector<uint8_t> &data)
+void NetworkManager::finishPendingMaze()
+{
+  if (!m_pendingMaze.valid() || m_pendingMaze.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return;
+
+  PendingMaze result = m_pendingMaze.get();
+  if (result.packedMaze.empty())
+  {
+    std::cout << "[DEBUG] Maze seed checksum mismatch, requesting full maze data" << std::endl;
+    sendRequestMaze();
+  }
+  else
+  {
+    setMazeSize(result.rows, result.cols);
+    setTickRate(result.tickRate);
+
+    if (m_onGameModeReceived)
+    {
+      m_onGameModeReceived(result.escapeMode);
+    }
+
+    if (m_onMazeData)
+    {
+      m_onMazeData(result.packedMaze, result.darkMode);
+    }
+  }
+
+  // 按原顺序处理生成期间收到的消息（其中可能又有 MazeSeed，此时剩下的继续暂存）
+  while (m_connected && !m_pendingMaze.valid() && !m_deferredMessages.empty())
+  {
+    InboundChunk message = std::move(m_deferredMessages.front());
+    m_deferredMessages.pop_front();
+    m_receiveTime = message.receivedAt;
+    processMessage(message.data);
+  }
+}
+
+void NetworkManager::flush()
+{
+  if (!m_connected)
+    return;
+
+  finishBatch();
+  finishDatagram();
+
+  // 先交出之前因队列已满暂存的数据，保持顺序
+  while (!m_outboundOverflow.empty() && m_outbound.push(std::move(m_outboundOverflow.front())))
+  {
+    m_outboundOverflow.pop_front();
+  }
+  m_outboundBytes = 0;
+  for (const auto &buffer : m_outboundOverflow)
+    m_outboundBytes += buffer.size();
+
+  if (m_outgoing.empty())
+    return;
+
+  if (!m_outboundOverflow.empty() || !m_outbound.push(std::move(m_outgoing)))
+  {
+    m_outboundBytes += m_outgoing.size();
+    m_outboundOverflow.push_back(std::move(m_outgoing));
+  }
+
+  // 换一个网络线程用完的缓冲区
+  m_outgoing.clear();
+  std::vector<uint8_t> recycled;
+  if (m_outboundFree.pop(recycled))
+  {
+    m_outgoing = std::move(recycled);
+    m_outgoing.clear();
+  }
+}
+
+void NetworkManager::sendPacket(std::span<const uint8_t> data)
 {
   if (!m_connected)
     return;
 
+  const std::size_t entrySize = 2 + data.size();
+
+  // 放不进批量包的大消息（如迷宫数据）单独发送，保持先后顺序
+  if (1 + entrySize > MAX_FRAME_SIZE)
+  {
+    finishBatch();
+    queueFrame(data.data(), data.size());
+    return;
+  }
+
+  // 当前批量包已满，先结束它
+  if (m_batch.size() + entrySize > MAX_FRAME_SIZE)
+    finishBatch();
+
+  if (m_batch.empty())
+    m_batch.push_back(static_cast<uint8_t>(NetMessageType::Batch));
+
+  uint16_t len = static_cast<uint16_t>(data.size());
+  m_batch.push_back(static_cast<uint8_t>(len & 0xFF));
+  m_batch.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
+  m_batch.insert(m_batch.end(), data.begin(), data.end());
+  ++m_batchCount;
+}
+
+void NetworkManager::queueFrame(const uint8_t *data, std::size_t size)
+{
   // 添加长度前缀 (2 bytes)
-  std::vector<uint8_t> packet;
+  uint16_t len = static_cast<uint16_t>(size);
+  m_outgoing.push_back(static_cast<uint8_t>(len & 0xFF));
+  m_outgoing.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
+  m_outgoing.insert(m_outgoing.end(), data, data + size);
+}
+
+void NetworkManager::finishBatch()
+{
+  if (m_batchCount == 1)
+  {
+    // 只有一条消息时去掉批量包头，按普通消息发送
+    queueFrame(m_batch.data() + 3, m_batch.size() - 3);
+  }
+  else if (m_batchCount > 1)
+  {
+    queueFrame(m_batch.data(), m_batch.size());
+  }
+
+  m_batch.clear();
+  m_batchCount = 0;
+}
+
+void NetworkManager::sendState(std::span<const uint8_t> data)
+{
+  if (!m_connected)
+    return;
+
+  if (!m_udpReady)
+  {
+    sendPacket(data);
+    return;
+  }
+
+  const std::size_t entrySize = 2 + data.size();
+  if (UDP_HEADER_SIZE + entrySize > MAX_DATAGRAM_SIZE)
+  {
+    sendPacket(data); // 太大的消息不适合走 UDP
+    return;
+  }
+
+  // 当前数据报放不下时先发出去，新开一个
+  if (m_datagram.size() + entrySize > MAX_DATAGRAM_SIZE)
+    finishDatagram();
+
+  if (m_datagram.empty())
+  {
+    std::vector<uint8_t> recycled;
+    if (m_outboundFree.pop(recycled))
+      m_datagram = std::move(recycled);
+    m_datagram.resize(UDP_HEADER_SIZE);
+  }
+
   uint16_t len = static_cast<uint16_t>(data.size());
-  packet.push_back(static_cast<uint8_t>(len & 0xFF));
-  packet.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
-  packet.insert(packet.end(), data.begin(), data.end());
+  m_datagram.push_back(static_cast<uint8_t>(len & 0xFF));
+  m_datagram.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
+  m_datagram.insert(m_datagram.end(), data.begin(), data.end());
+}
 
-  m_socket.setBlocking(true);
-  std::size_t sent = 0;
-  [[maybe_unused]] auto status = m_socket.send(packet.data(), packet.size(), sent);
-  m_socket.setBlocking(false);
+void NetworkManager::finishDatagram()
+{
+  if (m_datagram.size() <= UDP_HEADER_SIZE && !m_datagram.empty())
+    m_datagram.clear();
+  if (m_datagram.empty())
+    return;
+
+  // 包头：会话ID + 序号（小端）
+  const uint32_t sequence = ++m_udpSequence;
+  for (int i = 0; i < 4; ++i)
+  {
+    m_datagram[i] = static_cast<uint8_t>((m_sessionId >> (i * 8)) & 0xFF);
+    m_datagram[4 + i] = static_cast<uint8_t>((sequence >> (i * 8)) & 0xFF);
+  }
+
+  // 队列满时直接丢弃：状态消息下一帧会再发
+  m_udpOutbound.push(std::move(m_datagram));
+  m_datagram.clear();
+}
+
+void NetworkManager::sendUdpRegistration()
+{
+  std::vector<uint8_t> datagram(UDP_HEADER_SIZE, 0);
+  for (int i = 0; i < 4; ++i)
+    datagram[i] = static_cast<uint8_t>((m_sessionId >> (i * 8)) & 0xFF);
+  m_udpOutbound.push(std::move(datagram));
+  ++m_udpRegisterAttempts;
+  m_udpRegisterSentAt = std::chrono::steady_clock::now();
+}
+
+void NetworkManager::dispatchChunk(std::span<const uint8_t> chunk)
+{
+  // 网络线程只会打包完整的消息
+  std::size_t offset = 0;
+  while (m_connected && offset + 2 <= chunk.size())
+  {
+    uint16_t len = chunk[offset] | (chunk[offset + 1] << 8);
+    offset += 2;
+    if (offset + len > chunk.size())
+      break;
+    processMessage(chunk.subspan(offset, len));
+    offset += len;
+  }
+}
+
+void NetworkManager::networkThreadLoop()
+{
+  bool inboundStalled = false;
+
+  while (m_running)
+  {
+    // 取出主线程交来的数据放入发送队列
+    bool busy = false;
+    std::vector<uint8_t> buffer;
+    while (m_outbound.pop(buffer))
+    {
+      m_sendQueue.write(buffer.data(), buffer.size());
+      buffer.clear();
+      m_outboundFree.push(std::move(buffer));
+      busy = true;
+    }
+
+    if (!flushSendQueue())
+      break;
+
+    if (m_udpBound)
+    {
+      sendDatagrams();
+      receiveDatagrams();
+    }
+
+    // 主线程处理不过来时先不读，让 TCP 自己限流
+    if (inboundStalled)
+      inboundStalled = !pushReceived();
+    if (!inboundStalled)
+    {
+      if (!receiveData())
+        break;
+      inboundStalled = m_receiveEnd > m_receiveStart && !pushReceived();
+    }
+
+    // 每轮都要阻塞一下，不能空转：
+    // 内核发送缓冲区满（发送队列有剩余）或主线程处理不过来时，套接字可能一直可写/可读，只能睡眠等待；
+    // 否则等待套接字可读（最多 1 毫秒，以便及时取出新的发送数据）
+    if (inboundStalled || !m_sendQueue.empty())
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    else if (!busy)
+    {
+      m_selector.wait(sf::milliseconds(1));
+    }
+  }
+
+  // 退出前把剩余数据尽量写出（断开消息）
+  std::vector<uint8_t> buffer;
+  while (m_outbound.pop(buffer))
+  {
+    m_sendQueue.write(buffer.data(), buffer.size());
+  }
+  flushSendQueue();
+}
+
+void NetworkManager::sendDatagrams()
+{
+  std::vector<uint8_t> datagram;
+  while (m_udpOutbound.pop(datagram))
+  {
+    // 发送失败（缓冲区满等）直接丢弃，不重传
+    [[maybe_unused]] auto status = m_udpSocket.send(datagram.data(), datagram.size(), *m_serverAddress, m_serverPort);
+    datagram.clear();
+    m_outboundFree.push(std::move(datagram));
+  }
 }
 
-void NetworkManager::receiveData()
+void NetworkManager::receiveDatagrams()
 {
-  uint8_t buffer[1024];
-  std::size_t received = 0;
+  std::array<uint8_t, sf::UdpSocket::MaxDatagramSize> buffer;
+  while (true)
+  {
+    std::size_t received = 0;
+    std::optional<sf::IpAddress> sender;
+    unsigned short senderPort = 0;
+    if (m_udpSocket.receive(buffer.data(), buffer.size(), received, sender, senderPort) != sf::Socket::Status::Done)
+      break;
+
+    // 只接受服务器转发的数据报
+    if (!sender || *sender != *m_serverAddress || received < UDP_HEADER_SIZE)
+      continue;
+
+    // 只有包头的数据报是服务器对登记的回显：UDP 双向可用
+    if (received == UDP_HEADER_SIZE)
+    {
+      m_udpEchoed = true;
+      continue;
+    }
 
-  sf::Socket::Status status = m_socket.receive(buffer, sizeof(buffer), received);
+    uint32_t sessionId = 0;
+    uint32_t sequence = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      sessionId |= static_cast<uint32_t>(buffer[i]) << (i * 8);
+      sequence |= static_cast<uint32_t>(buffer[4 + i]) << (i * 8);
+    }
+
+    // 丢弃乱序到达的旧数据报（序号回绕时按差值比较）
+    auto it = m_udpLastSequence.find(sessionId);
+    if (it != m_udpLastSequence.end() && static_cast<int32_t>(sequence - it->second) <= 0)
+      continue;
+    m_udpLastSequence[sessionId] = sequence;
+
+    // 数据报的负载与 TCP 数据段格式相同，直接交给主线程
+    InboundChunk chunk;
+    m_inboundFree.pop(chunk.data);
+    chunk.data.assign(buffer.begin() + UDP_HEADER_SIZE, buffer.begin() + received);
+    chunk.receivedAt = std::chrono::steady_clock::now();
+    m_inbound.push(std::move(chunk)); // 主线程处理不过来时丢弃
+  }
+}
 
-  if (status == sf::Socket::Status::Done && received > 0)
+bool NetworkManager::flushSendQueue()
+{
+  while (!m_sendQueue.empty())
   {
-    m_receiveBuffer.insert(m_receiveBuffer.end(), buffer, buffer + received);
+    auto chunk = m_sendQueue.front();
+    std::size_t sent = 0;
+    sf::Socket::Status status = m_socket.send(chunk.data(), chunk.size(), sent);
 
-    // 处理完整的消息
-    while (m_receiveBuffer.size() >= 2)
+    if (status == sf::Socket::Status::Done)
+    {
+      m_sendQueue.consume(chunk.size());
+    }
+    else if (status == sf::Socket::Status::Partial || status == sf::Socket::Status::NotReady)
+    {
+      // 内核缓冲区已满，剩余数据稍后再发
+      m_sendQueue.consume(sent);
+      break;
+    }
+    else
     {
-      uint16_t len = m_receiveBuffer[0] | (m_receiveBuffer[1] << 8);
+      m_sendQueue.clear();
+      m_socketClosed = true;
+      m_queuedBytes.store(0, std::memory_order_relaxed);
+      return false;
+    }
+  }
 
-      if (m_receiveBuffer.size() >= 2 + len)
+  m_queuedBytes.store(m_sendQueue.size(), std::memory_order_relaxed);
+  return true;
+}
+
+bool NetworkManager::receiveData()
+{
+  while (true)
+  {
+    // 保证尾部至少有 RECEIVE_CHUNK 的空间：先把未打包的数据移到开头，不够再扩容
+    if (m_receiveBuffer.size() - m_receiveEnd < RECEIVE_CHUNK)
+    {
+      if (m_receiveStart > 0)
       {
-        std::vector<uint8_t> message(m_receiveBuffer.begin() + 2,
-                                     m_receiveBuffer.begin() + 2 + len);
-        m_receiveBuffer.erase(m_receiveBuffer.begin(),
-                              m_receiveBuffer.begin() + 2 + len);
-        processMessage(message);
+        std::memmove(m_receiveBuffer.data(), m_receiveBuffer.data() + m_receiveStart, m_receiveEnd - m_receiveStart);
+        m_receiveEnd -= m_receiveStart;
+        m_receiveStart = 0;
       }
-      else
+      if (m_receiveBuffer.size() - m_receiveEnd < RECEIVE_CHUNK)
       {
-        break; // 等待更多数据
+        m_receiveBuffer.resize(std::max(m_receiveBuffer.size() * 2, m_receiveEnd + RECEIVE_CHUNK));
       }
     }
-  }
-  else if (status == sf::Socket::Status::Disconnected)
-  {
-    m_connected = false;
-    if (m_onDisconnected)
+
+    std::size_t received = 0;
+    sf::Socket::Status status = m_socket.receive(m_receiveBuffer.data() + m_receiveEnd,
+                                                 m_receiveBuffer.size() - m_receiveEnd, received);
+
+    if (status == sf::Socket::Status::Done || status == sf::Socket::Status::Partial)
     {
-      m_onDisconnected();
+      m_receiveEnd += received;
+    }
+    else if (status == sf::Socket::Status::NotReady)
+    {
+      return true; // 已经读完
+    }
+    else
+    {
+      // 断开前已收到的完整消息仍然交给主线程
+      pushReceived();
+      m_socketClosed = true;
+      return false;
     }
   }
 }
 
-void NetworkManager::processMessage(const std::vector<uint8_t> &data)
+bool NetworkManager::pushReceived()
+{
+  // 找出开头连续的完整消息
+  std::size_t end = m_receiveStart;
+  while (m_receiveEnd - end >= 2)
+  {
+    uint16_t len = m_receiveBuffer[end] | (m_receiveBuffer[end + 1] << 8);
+    if (m_receiveEnd - end < 2u + len)
+      break; // 等待更多数据
+    end += 2 + len;
+  }
+  if (end == m_receiveStart)
+    return true;
+
+  // 一次拷贝整段数据，尽量复用主线程送回的缓冲区
+  InboundChunk chunk;
+  m_inboundFree.pop(chunk.data);
+  chunk.data.assign(m_receiveBuffer.begin() + m_receiveStart, m_receiveBuffer.begin() + end);
+  chunk.receivedAt = std::chrono::steady_clock::now();
+  if (!m_inbound.push(std::move(chunk)))
+    return false;
+
+  m_receiveStart = end;
+  if (m_receiveStart == m_receiveEnd)
+  {
+    m_receiveStart = 0;
+    m_receiveEnd = 0;
+  }
+  return true;
+}
+
+void NetworkManager::processMessage(std::span<const uint8_t> data)
 {
   if (data.empty())
     return;
 
   NetMessageType type = static_cast<NetMessageType>(data[0]);
 
+  // 种子迷宫还在后台生成：暂存消息，生成完成后按顺序处理（批量包先拆开）
+  if (m_pendingMaze.valid() && type != NetMessageType::Batch)
+  {
+    m_deferredMessages.push_back({std::vector<uint8_t>(data.begin(), data.end()), m_receiveTime});
+    return;
+  }
+
   auto readFloat = [&data](size_t offset) -> float
   {
     if (offset + 4 > data.size())
@@ -515,6 +1078,35 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
 
   switch (type)
   {
+  case NetMessageType::Batch:
+  {
+    // 逐条拆出批量包中的消息
+    size_t offset = 1;
+    while (offset + 2 <= data.size())
+    {
+      uint16_t len = data[offset] | (data[offset + 1] << 8);
+      offset += 2;
+      if (offset + len > data.size())
+        break;
+      processMessage(data.subspan(offset, len));
+      offset += len;
+    }
+    break;
+  }
+  case NetMessageType::ConnectAck:
+  {
+    // 服务器分配的会话ID，用于 UDP 通道
+    if (data.size() >= 5 && m_udpBound)
+    {
+      m_sessionId = data[1] | (data[2] << 8) | (data[3] << 16) | (static_cast<uint32_t>(data[4]) << 24);
+      // 先登记，收到服务器回显之前状态消息仍走 TCP
+      m_udpReady = false;
+      m_udpEchoed = false;
+      m_udpRegisterAttempts = 0;
+      sendUdpRegistration();
+    }
+    break;
+  }
   case NetMessageType::RoomCreated:
   {
     if (data.size() > 2)
@@ -566,32 +1158,25 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
   case NetMessageType::MazeData:
   {
     // 解析迷宫数据
-    if (data.size() >= 4)
+    if (data.size() >= 5)
     {
-      size_t offset = 1;
-
       // 读取游戏模式标志: bit 0 = isEscapeMode, bit 1 = isDarkMode
-      uint8_t modeFlags = data[offset];
+      uint8_t modeFlags = data[1];
       bool isEscapeMode = (modeFlags & 1) != 0;
       bool isDarkMode = (modeFlags & 2) != 0;
-      offset += 1;
 
-      uint16_t rows = data[offset] | (data[offset + 1] << 8);
-      offset += 2;
-
-      std::vector<std::string> mazeData;
-      for (uint16_t i = 0; i < rows && offset + 2 <= data.size(); i++)
+      // 压缩的迷宫数据直接交给回调（不复制），损坏的数据丢弃
+      std::span<const uint8_t> packedMaze = data.subspan(3);
+      MazeCodec::Header header;
+      if (!MazeCodec::validate(packedMaze, header))
       {
-        uint16_t len = data[offset] | (data[offset + 1] << 8);
-        offset += 2;
-        if (offset + len <= data.size())
-        {
-          std::string row(data.begin() + offset, data.begin() + offset + len);
-          mazeData.push_back(row);
-          offset += len;
-        }
+        std::cout << "[DEBUG] Invalid maze data received" << std::endl;
+        break;
       }
 
+      setMazeSize(header.rows, header.cols);
+      setTickRate(data[2]); // 使用房主的节拍频率
+
       // 先设置游戏模式，再回调 MazeData
       if (m_onGameModeReceived)
       {
@@ -600,14 +1185,62 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
 
       if (m_onMazeData)
       {
-        m_onMazeData(mazeData, isDarkMode);
+        m_onMazeData(packedMaze, isDarkMode);
+      }
+    }
+    break;
+  }
+  case NetMessageType::MazeSeed:
+  {
+    // 按房主的参数生成迷宫，校验和一致才使用，否则请求完整数据
+    if (data.size() >= 17)
+    {
+      auto readU32 = [&data](size_t offset) -> uint32_t
+      {
+        return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) |
+               (static_cast<uint32_t>(data[offset + 3]) << 24);
+      };
+
+      const uint8_t modeFlags = data[1];
+      MazeRecipe recipe;
+      recipe.escapeMode = (modeFlags & 1) != 0;
+      recipe.seed = readU32(2);
+      recipe.width = data[6] | (data[7] << 8);
+      recipe.height = data[8] | (data[9] << 8);
+      recipe.enemyCount = data[10] | (data[11] << 8);
+      const uint32_t checksum = readU32(12);
+
+      // 参数来自网络，超出大厅范围时不生成（过小的尺寸会越界，过大的会耗尽内存）
+      if (!MazeGenerator::isValidRecipe(recipe))
+      {
+        std::cout << "[DEBUG] Invalid maze seed parameters, requesting full maze data" << std::endl;
+        sendRequestMaze();
+        break;
       }
+
+      // 大地图生成需要时间，放到后台线程；完成前收到的消息暂存（见 finishPendingMaze）
+      PendingMaze pending;
+      pending.escapeMode = recipe.escapeMode;
+      pending.darkMode = (modeFlags & 2) != 0;
+      pending.tickRate = data[16]; // 使用房主的节拍频率
+      auto generate = [recipe, checksum, pending]() mutable
+      {
+        std::vector<std::string> mazeData = MazeGenerator::generateFromRecipe(recipe);
+        if (MazeGenerator::checksum(mazeData) == checksum)
+        {
+          pending.rows = static_cast<int>(mazeData.size());
+          pending.cols = mazeData.empty() ? 0 : static_cast<int>(mazeData[0].size());
+          MazeCodec::encode(mazeData, pending.packedMaze);
+        }
+        return pending;
+      };
+      m_pendingMaze = std::async(std::launch::async, std::move(generate));
     }
     break;
   }
   case NetMessageType::RequestMaze:
   {
-    // 服务器请求房主发送迷宫数据
+    // 服务器或对方（种子生成结果不一致）请求房主发送完整迷宫数据
     if (m_onRequestMaze)
     {
       m_onRequestMaze();
@@ -616,16 +1249,9 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
   }
   case NetMessageType::PlayerUpdate:
   {
-    if (data.size() >= 22)
+    PlayerState state;
+    if (m_stateCodec.decodePlayer(data.subspan(1), state))
     {
-      PlayerState state;
-      state.x = readFloat(1);
-      state.y = readFloat(5);
-      state.rotation = readFloat(9);
-      state.turretAngle = readFloat(13);
-      state.health = readFloat(17);
-      state.reachedExit = data[21] != 0;
-      state.isDead = (data.size() >= 23) ? (data[22] != 0) : false; // 读取死亡状态
       if (m_onPlayerUpdate)
       {
         m_onPlayerUpdate(state);
@@ -690,21 +1316,59 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
     }
     break;
   }
-  case NetMessageType::NpcUpdate:
+  case NetMessageType::NpcSnapshot:
+  {
+    // NPC增量快照：还原出所有NPC的状态逐个通知，并确认收到
+    uint16_t snapshotId = 0;
+    if (m_npcReceiver.decode(data.subspan(1), m_stateCodec, m_npcStates, snapshotId))
+    {
+      if (m_onNpcUpdate)
+      {
+        for (const NpcState &state : m_npcStates)
+          m_onNpcUpdate(state);
+      }
+
+      uint8_t ack[3] = {static_cast<uint8_t>(NetMessageType::NpcSnapshotAck),
+                        static_cast<uint8_t>(snapshotId & 0xFF),
+                        static_cast<uint8_t>(snapshotId >> 8)};
+      sendState(ack);
+    }
+    break;
+  }
+  case NetMessageType::NpcSnapshotAck:
+  {
+    if (data.size() >= 3)
+    {
+      m_npcSender.acknowledge(static_cast<uint16_t>(data[1] | (data[2] << 8)));
+    }
+    break;
+  }
+  case NetMessageType::PlayerInput:
+  {
+    // 非房主的输入（房主处理）
+    const std::size_t count = data.size() >= 2 ? data[1] : 0;
+    if (m_onPlayerInput && count > 0 && data.size() >= 2 + count * 7)
+    {
+      m_inputs.resize(count);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        const uint8_t *entry = data.data() + 2 + i * 7;
+        InputCommand &input = m_inputs[i];
+        input.sequence = entry[0] | (entry[1] << 8) | (entry[2] << 16) | (static_cast<uint32_t>(entry[3]) << 24);
+        input.keys = entry[4];
+        input.dt = static_cast<float>(entry[5] | (entry[6] << 8)) / INPUT_DT_STEPS_PER_SECOND;
+      }
+      m_onPlayerInput(m_inputs);
+    }
+    break;
+  }
+  case NetMessageType::PlayerCorrection:
   {
-    // NPC状态更新
-    if (data.size() >= 24 && m_onNpcUpdate)
+    // 房主发回的权威位置（非房主处理）
+    if (m_onPlayerCorrection && data.size() >= 17)
     {
-      NpcState state;
-      state.id = data[1];
-      state.x = readFloat(2);
-      state.y = readFloat(6);
-      state.rotation = readFloat(10);
-      state.turretAngle = readFloat(14);
-      state.health = readFloat(18);
-      state.team = data[22];
-      state.activated = data[23] != 0;
-      m_onNpcUpdate(state);
+      uint32_t lastInput = data[1] | (data[2] << 8) | (data[3] << 16) | (static_cast<uint32_t>(data[4]) << 24);
+      m_onPlayerCorrection(lastInput, {readFloat(5), readFloat(9)}, readFloat(13));
     }
     break;
   }
@@ -734,7 +1398,9 @@ void NetworkManager::processMessage(const std::vector<uint8_t> &data)
   }
   case NetMessageType::PlayerLeft:
   {
-    // 对方玩家离开房间
+    // 对方玩家离开房间，新加入的玩家需要从关键帧开始
+    m_npcSender.reset();
+    m_npcReceiver.reset();
     if (m_onPlayerLeft)
     {
       bool becameHost = (data.size() >= 2) ? (data[1] != 0) : false;
@@ -0,0 +1,168 @@
+#include "NpcSnapshot.hpp"
+#include "NetworkManager.hpp"
+#include <algorithm>
+
+namespace
+{
+  // 在按 ID 排序的 NPC 列表中查找
+  const QuantizedNpc *findNpc(const std::vector<QuantizedNpc> &npcs, std::uint8_t id)
+  {
+    auto it = std::lower_bound(npcs.begin(), npcs.end(), id,
+                               [](const QuantizedNpc &npc, std::uint8_t value)
+                               { return npc.id < value; });
+    return (it != npcs.end() && it->id == id) ? &*it : nullptr;
+  }
+
+  // 历史中的快照（ID 不匹配说明已被覆盖）
+  template <typename History>
+  auto *findFrame(History &history, std::uint16_t id)
+  {
+    auto &frame = history[id % NpcSnapshot::HISTORY_SIZE];
+    return frame.id == id ? &frame : nullptr;
+  }
+}
+
+void NpcSnapshotSender::encode(std::span<const NpcState> states, std::uint32_t tick, const StateCodec &codec, std::vector<std::uint8_t> &out)
+{
+  // KEYFRAME 是基准ID的哨兵，也是空历史槽的 ID，不能分配给快照
+  if (m_nextId == NpcSnapshot::KEYFRAME)
+    m_nextId = 0;
+  const std::uint16_t id = m_nextId++;
+
+  // 基准：对方确认过、仍在历史中且不太旧的快照；否则发送关键帧
+  const NpcSnapshot::Frame *baseline = nullptr;
+  if (m_hasAck && m_sinceKeyframe < KEYFRAME_INTERVAL &&
+      static_cast<std::uint16_t>(id - m_ackedId) < NpcSnapshot::HISTORY_SIZE)
+  {
+    baseline = findFrame(m_history, m_ackedId);
+  }
+  m_sinceKeyframe = baseline ? m_sinceKeyframe + 1 : 0;
+
+  // 本快照的完整状态写入历史（覆盖最旧的一个）
+  NpcSnapshot::Frame &frame = m_history[id % NpcSnapshot::HISTORY_SIZE];
+  frame.id = id;
+  frame.npcs.clear();
+  for (const NpcState &state : states)
+    frame.npcs.push_back(codec.quantizeNpc(state));
+  std::sort(frame.npcs.begin(), frame.npcs.end(),
+            [](const QuantizedNpc &a, const QuantizedNpc &b)
+            { return a.id < b.id; });
+
+  // 头部
+  const std::uint16_t baselineId = baseline ? baseline->id : NpcSnapshot::KEYFRAME;
+  const std::size_t headerPos = out.size();
+  out.resize(headerPos + NpcSnapshot::HEADER_SIZE + frame.npcs.size() * (2 + StateCodec::MAX_STATE_BYTES));
+  std::uint8_t *header = out.data() + headerPos;
+  header[0] = static_cast<std::uint8_t>(id & 0xFF);
+  header[1] = static_cast<std::uint8_t>(id >> 8);
+  header[2] = static_cast<std::uint8_t>(baselineId & 0xFF);
+  header[3] = static_cast<std::uint8_t>(baselineId >> 8);
+  for (int i = 0; i < 4; ++i)
+    header[4 + i] = static_cast<std::uint8_t>(tick >> (i * 8));
+
+  // 条目：只写有变化的 NPC
+  BitWriter writer(header + NpcSnapshot::HEADER_SIZE, out.size() - headerPos - NpcSnapshot::HEADER_SIZE);
+  int count = 0;
+  for (const QuantizedNpc &npc : frame.npcs)
+  {
+    const QuantizedNpc *previous = baseline ? findNpc(baseline->npcs, npc.id) : nullptr;
+    const std::uint8_t mask = previous ? StateCodec::diffNpc(*previous, npc) : static_cast<std::uint8_t>(NpcFieldAll);
+    if (mask == 0)
+      continue;
+
+    writer.write(npc.id, 8);
+    writer.write(mask, 5);
+    codec.writeNpcFields(writer, npc, mask);
+    ++count;
+  }
+  header[8] = static_cast<std::uint8_t>(count);
+  out.resize(headerPos + NpcSnapshot::HEADER_SIZE + writer.bytes());
+}
+
+void NpcSnapshotSender::acknowledge(std::uint16_t snapshotId)
+{
+  // 只接受比当前基准更新、且确实发送过的快照
+  if (!findFrame(m_history, snapshotId))
+    return;
+  if (!m_hasAck || NpcSnapshot::isNewer(snapshotId, m_ackedId))
+  {
+    m_ackedId = snapshotId;
+    m_hasAck = true;
+  }
+}
+
+void NpcSnapshotSender::reset()
+{
+  m_hasAck = false;
+  m_ackedId = NpcSnapshot::KEYFRAME;
+  m_sinceKeyframe = 0;
+  for (auto &frame : m_history)
+    frame.id = NpcSnapshot::KEYFRAME;
+}
+
+bool NpcSnapshotReceiver::decode(std::span<const std::uint8_t> data, const StateCodec &codec,
+                                 std::vector<NpcState> &outStates, std::uint16_t &outSnapshotId)
+{
+  outStates.clear();
+  if (data.size() < NpcSnapshot::HEADER_SIZE)
+    return false;
+
+  const std::uint16_t id = static_cast<std::uint16_t>(data[0] | (data[1] << 8));
+  const std::uint16_t baselineId = static_cast<std::uint16_t>(data[2] | (data[3] << 8));
+  const std::uint32_t tick = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<std::uint32_t>(data[7]) << 24);
+  const int count = data[8];
+
+  const NpcSnapshot::Frame *baseline = nullptr;
+  if (baselineId != NpcSnapshot::KEYFRAME)
+  {
+    baseline = findFrame(m_history, baselineId);
+    if (!baseline)
+      return false; // 基准已丢失，等待关键帧
+  }
+
+  // 新快照 = 基准 + 变化；先在临时帧中还原，成功后再写入历史
+  NpcSnapshot::Frame frame;
+  frame.id = id;
+  if (baseline)
+    frame.npcs = baseline->npcs;
+
+  BitReader reader(data.subspan(NpcSnapshot::HEADER_SIZE));
+  for (int i = 0; i < count; ++i)
+  {
+    const std::uint8_t npcId = static_cast<std::uint8_t>(reader.read(8));
+    const std::uint8_t mask = static_cast<std::uint8_t>(reader.read(5));
+
+    auto it = std::lower_bound(frame.npcs.begin(), frame.npcs.end(), npcId,
+                               [](const QuantizedNpc &npc, std::uint8_t value)
+                               { return npc.id < value; });
+    if (it == frame.npcs.end() || it->id != npcId)
+    {
+      QuantizedNpc npc;
+      npc.id = npcId;
+      it = frame.npcs.insert(it, npc);
+    }
+    codec.readNpcFields(reader, *it, mask);
+    if (reader.overflowed())
+      return false;
+  }
+
+  // 输出所有 NPC（包括未变化的），接收端每个节拍都能得到完整的一组样本
+  for (const QuantizedNpc &npc : frame.npcs)
+  {
+    outStates.push_back(codec.dequantizeNpc(npc));
+    outStates.back().tick = tick;
+  }
+
+  m_history[id % NpcSnapshot::HISTORY_SIZE] = std::move(frame);
+  outSnapshotId = id;
+  return true;
+}
+
+void NpcSnapshotReceiver::reset()
+{
+  for (auto &frame : m_history)
+  {
+    frame.id = NpcSnapshot::KEYFRAME;
+    frame.npcs.clear();
+  }
+}
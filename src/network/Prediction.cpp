@@ -0,0 +1,133 @@
+#include "Prediction.hpp"
+#include <algorithm>
+#include <cmath>
+
+float quantizeInputDt(float dt)
+{
+  const float clamped = std::clamp(dt, 0.f, MAX_INPUT_DT);
+  return std::round(clamped * INPUT_DT_STEPS_PER_SECOND) / INPUT_DT_STEPS_PER_SECOND;
+}
+
+void stepTank(Tank &tank, const Maze &maze, const InputCommand &input)
+{
+  tank.setMoveKeys(input.keys);
+
+  // 保存旧位置
+  sf::Vector2f oldPos = tank.getPosition();
+  sf::Vector2f movement = tank.getMovement(input.dt);
+
+  tank.updateMovement(input.dt, input.aim);
+
+  // 碰撞检测：撞墙时尝试只沿一个轴移动（贴墙滑动）
+  sf::Vector2f newPos = tank.getPosition();
+  float radius = tank.getCollisionRadius();
+
+  if (maze.checkCollision(newPos, radius))
+  {
+    sf::Vector2f posX = {oldPos.x + movement.x, oldPos.y};
+    sf::Vector2f posY = {oldPos.x, oldPos.y + movement.y};
+
+    bool canMoveX = !maze.checkCollision(posX, radius);
+    bool canMoveY = !maze.checkCollision(posY, radius);
+
+    if (canMoveX && canMoveY)
+    {
+      if (std::abs(movement.x) > std::abs(movement.y))
+        tank.setPosition(posX);
+      else
+        tank.setPosition(posY);
+    }
+    else if (canMoveX)
+    {
+      tank.setPosition(posX);
+    }
+    else if (canMoveY)
+    {
+      tank.setPosition(posY);
+    }
+    else
+    {
+      tank.setPosition(oldPos);
+    }
+  }
+}
+
+const InputCommand &InputHistory::record(std::uint8_t keys, float dt, sf::Vector2f aim)
+{
+  if (m_pending.size() == MAX_PENDING)
+    m_pending.pop_front();
+
+  InputCommand input;
+  input.sequence = m_nextSequence++;
+  input.keys = keys;
+  input.dt = quantizeInputDt(dt);
+  input.aim = aim;
+  m_pending.push_back(input);
+  return m_pending.back();
+}
+
+void InputHistory::recent(std::vector<InputCommand> &out) const
+{
+  const std::size_t count = std::min(m_pending.size(), NetworkManager::MAX_INPUTS_PER_MESSAGE);
+  out.assign(m_pending.end() - static_cast<std::ptrdiff_t>(count), m_pending.end());
+}
+
+bool InputHistory::acknowledge(std::uint32_t sequence)
+{
+  if (sequence < m_lastAck || sequence >= m_nextSequence)
+    return false;
+
+  m_lastAck = sequence;
+  while (!m_pending.empty() && m_pending.front().sequence <= sequence)
+    m_pending.pop_front();
+  return true;
+}
+
+void InputHistory::replay(Tank &tank, const Maze &maze) const
+{
+  const std::uint8_t keys = tank.getMoveKeys();
+  for (const InputCommand &input : m_pending)
+    stepTank(tank, maze, input);
+  tank.setMoveKeys(keys); // 恢复当前实际按下的键
+}
+
+void InputHistory::clear()
+{
+  // 序号在整个连接期间递增，上一局残留的确认不会被误认为新的
+  m_pending.clear();
+}
+
+void InputAuthority::reset(sf::Vector2f spawn, float scale)
+{
+  m_tank = std::make_unique<Tank>();
+  m_tank->setScale(scale);
+  m_tank->setPosition(spawn);
+  m_lastInput = 0;
+  m_dirty = false;
+}
+
+void InputAuthority::apply(std::span<const InputCommand> inputs, const Maze &maze)
+{
+  if (!m_tank)
+    return;
+
+  for (const InputCommand &input : inputs)
+  {
+    if (input.sequence <= m_lastInput)
+      continue;
+
+    InputCommand command = input;
+    command.dt = quantizeInputDt(input.dt);
+    command.aim = m_tank->getPosition(); // 炮塔由对方的状态消息同步，这里不关心
+    stepTank(*m_tank, maze, command);
+    m_lastInput = input.sequence;
+    m_dirty = true;
+  }
+}
+
+bool InputAuthority::takeCorrection()
+{
+  const bool dirty = m_dirty;
+  m_dirty = false;
+  return dirty;
+}
@@ -0,0 +1,106 @@
+#include "SnapshotInterpolation.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+
+double RemoteClock::localSeconds(std::chrono::steady_clock::time_point time) const
+{
+  return std::chrono::duration<double>(time - m_epoch).count();
+}
+
+double RemoteClock::observe(std::uint32_t tick, float tickInterval, std::chrono::steady_clock::time_point receivedAt)
+{
+  const double remote = static_cast<double>(tick) * tickInterval;
+  if (!m_valid)
+  {
+    m_epoch = receivedAt;
+    m_offset = -remote;
+    m_latest = remote;
+    m_valid = true;
+    return remote;
+  }
+
+  const double offset = localSeconds(receivedAt) - remote;
+  if (std::abs(offset - m_offset) > RESYNC_THRESHOLD)
+  {
+    // 对方节拍跳变，重新同步
+    m_offset = offset;
+    m_latest = remote;
+    return remote;
+  }
+
+  if (offset < m_offset)
+    m_offset = offset;
+  else
+    m_offset += (offset - m_offset) * OFFSET_DRIFT;
+  m_latest = std::max(m_latest, remote);
+  return remote;
+}
+
+double RemoteClock::renderTime(std::chrono::steady_clock::time_point now, float tickInterval) const
+{
+  return localSeconds(now) - m_offset - INTERPOLATION_TICKS * tickInterval;
+}
+
+void SnapshotBuffer::push(const EntitySnapshot &snapshot)
+{
+  if (m_count > 0)
+  {
+    const EntitySnapshot &last = at(m_count - 1);
+    // 时间大幅倒退说明对方重新开始计时，丢弃旧数据
+    if (snapshot.time < last.time - 1.0)
+      m_count = 0;
+    else if (snapshot.time <= last.time)
+      return;
+  }
+
+  if (m_count == CAPACITY)
+  {
+    m_start = (m_start + 1) % CAPACITY;
+    --m_count;
+  }
+  m_items[(m_start + m_count) % CAPACITY] = snapshot;
+  ++m_count;
+}
+
+bool SnapshotBuffer::sample(double renderTime, EntitySnapshot &out) const
+{
+  if (m_count == 0)
+    return false;
+
+  // 只有一个快照，或早于最旧快照：直接显示最旧的
+  if (m_count == 1 || renderTime <= at(0).time)
+  {
+    out = at(0);
+    return true;
+  }
+
+  // 找到 renderTime 所在的区间（快照很少，线性查找即可）
+  std::size_t next = 1;
+  while (next < m_count && at(next).time < renderTime)
+    ++next;
+
+  const EntitySnapshot *from;
+  const EntitySnapshot *to;
+  double t;
+  if (next < m_count)
+  {
+    from = &at(next - 1);
+    to = &at(next);
+    t = (renderTime - from->time) / (to->time - from->time);
+  }
+  else
+  {
+    // 数据不足：沿最后两个快照的运动方向外推
+    from = &at(m_count - 2);
+    to = &at(m_count - 1);
+    const double extrapolate = std::min(renderTime - to->time, MAX_EXTRAPOLATION);
+    t = 1.0 + extrapolate / (to->time - from->time);
+  }
+
+  const float ft = static_cast<float>(t);
+  out.time = renderTime;
+  out.position = from->position + (to->position - from->position) * ft;
+  out.rotation = Utils::lerpAngle(from->rotation, to->rotation, ft);
+  out.turretAngle = Utils::lerpAngle(from->turretAngle, to->turretAngle, ft);
+  return true;
+}
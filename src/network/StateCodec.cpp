@@ -0,0 +1,212 @@
+#include "StateCodec.hpp"
+#include "NetworkManager.hpp"
+#include <algorithm>
+#include <cmath>
+
+BitWriter::BitWriter(std::uint8_t *data, std::size_t capacity)
+    : m_data(data), m_capacity(capacity)
+{
+}
+
+void BitWriter::write(std::uint32_t value, int bits)
+{
+  if (m_bitPos + bits > m_capacity * 8)
+  {
+    m_overflow = true;
+    return;
+  }
+
+  for (int i = 0; i < bits; ++i)
+  {
+    const std::size_t byte = m_bitPos >> 3;
+    const int shift = static_cast<int>(m_bitPos & 7);
+    if (shift == 0)
+      m_data[byte] = 0; // 新的字节先清零
+    m_data[byte] |= static_cast<std::uint8_t>(((value >> i) & 1u) << shift);
+    ++m_bitPos;
+  }
+}
+
+BitReader::BitReader(std::span<const std::uint8_t> data)
+    : m_data(data)
+{
+}
+
+std::uint32_t BitReader::read(int bits)
+{
+  if (m_bitPos + bits > m_data.size() * 8)
+  {
+    m_overflow = true;
+    return 0;
+  }
+
+  std::uint32_t value = 0;
+  for (int i = 0; i < bits; ++i)
+  {
+    const std::uint32_t bit = (m_data[m_bitPos >> 3] >> (m_bitPos & 7)) & 1u;
+    value |= bit << i;
+    ++m_bitPos;
+  }
+  return value;
+}
+
+void StateCodec::setWorldSize(sf::Vector2f size)
+{
+  m_worldSize = size;
+  const float extent[2] = {size.x, size.y};
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    // 覆盖整个地图所需的位数
+    const float steps = std::max(extent[axis], 1.f) * POSITION_STEPS_PER_PIXEL;
+    m_positionBits[axis] = std::clamp(static_cast<int>(std::ceil(std::log2(steps + 1.f))), 8, 24);
+  }
+}
+
+std::uint32_t StateCodec::quantizePosition(float value, int axis) const
+{
+  const float extent = axis == 0 ? m_worldSize.x : m_worldSize.y;
+  const std::uint32_t maxValue = (1u << m_positionBits[axis]) - 1;
+  const float steps = std::round(std::clamp(value, 0.f, extent) * POSITION_STEPS_PER_PIXEL);
+  return std::min(static_cast<std::uint32_t>(steps), maxValue);
+}
+
+void StateCodec::writePosition(BitWriter &writer, float x, float y) const
+{
+  writer.write(quantizePosition(x, 0), m_positionBits[0]);
+  writer.write(quantizePosition(y, 1), m_positionBits[1]);
+}
+
+void StateCodec::readPosition(BitReader &reader, float &x, float &y) const
+{
+  x = static_cast<float>(reader.read(m_positionBits[0])) / POSITION_STEPS_PER_PIXEL;
+  y = static_cast<float>(reader.read(m_positionBits[1])) / POSITION_STEPS_PER_PIXEL;
+}
+
+std::uint32_t StateCodec::quantizeAngle(float degrees)
+{
+  float normalized = std::fmod(degrees, 360.f);
+  if (normalized < 0.f)
+    normalized += 360.f;
+  const std::uint32_t steps = 1u << ANGLE_BITS;
+  return static_cast<std::uint32_t>(std::lround(normalized / 360.f * steps)) & (steps - 1);
+}
+
+float StateCodec::dequantizeAngle(std::uint32_t value)
+{
+  return static_cast<float>(value) * 360.f / static_cast<float>(1u << ANGLE_BITS);
+}
+
+std::uint32_t StateCodec::quantizeHealth(float health)
+{
+  return static_cast<std::uint32_t>(std::clamp(std::lround(health * HEALTH_SCALE), 0l, 255l));
+}
+
+std::size_t StateCodec::encodePlayer(const PlayerState &state, std::uint8_t *out) const
+{
+  BitWriter writer(out, MAX_STATE_BYTES);
+  writer.write(state.tick, 32);
+  writePosition(writer, state.x, state.y);
+  writer.write(quantizeAngle(state.rotation), ANGLE_BITS);
+  writer.write(quantizeAngle(state.turretAngle), ANGLE_BITS);
+  writer.write(quantizeHealth(state.health), 8);
+  writer.write(state.reachedExit ? 1 : 0, 1);
+  writer.write(state.isDead ? 1 : 0, 1);
+  return writer.bytes();
+}
+
+bool StateCodec::decodePlayer(std::span<const std::uint8_t> data, PlayerState &state) const
+{
+  BitReader reader(data);
+  state.tick = reader.read(32);
+  readPosition(reader, state.x, state.y);
+  state.rotation = dequantizeAngle(reader.read(ANGLE_BITS));
+  state.turretAngle = dequantizeAngle(reader.read(ANGLE_BITS));
+  state.health = static_cast<float>(reader.read(8)) / HEALTH_SCALE;
+  state.reachedExit = reader.read(1) != 0;
+  state.isDead = reader.read(1) != 0;
+  return !reader.overflowed();
+}
+
+QuantizedNpc StateCodec::quantizeNpc(const NpcState &state) const
+{
+  QuantizedNpc npc;
+  npc.id = static_cast<std::uint8_t>(state.id);
+  npc.x = quantizePosition(state.x, 0);
+  npc.y = quantizePosition(state.y, 1);
+  npc.rotation = static_cast<std::uint16_t>(quantizeAngle(state.rotation));
+  npc.turretAngle = static_cast<std::uint16_t>(quantizeAngle(state.turretAngle));
+  npc.health = static_cast<std::uint8_t>(quantizeHealth(state.health));
+  npc.team = static_cast<std::uint8_t>(state.team & 3); // 阵营 0-2
+  npc.activated = state.activated;
+  return npc;
+}
+
+NpcState StateCodec::dequantizeNpc(const QuantizedNpc &npc) const
+{
+  NpcState state;
+  state.id = npc.id;
+  state.x = static_cast<float>(npc.x) / POSITION_STEPS_PER_PIXEL;
+  state.y = static_cast<float>(npc.y) / POSITION_STEPS_PER_PIXEL;
+  state.rotation = dequantizeAngle(npc.rotation);
+  state.turretAngle = dequantizeAngle(npc.turretAngle);
+  state.health = static_cast<float>(npc.health) / HEALTH_SCALE;
+  state.team = npc.team;
+  state.activated = npc.activated;
+  return state;
+}
+
+std::uint8_t StateCodec::diffNpc(const QuantizedNpc &baseline, const QuantizedNpc &current)
+{
+  std::uint8_t mask = 0;
+  if (baseline.x != current.x || baseline.y != current.y)
+    mask |= NpcFieldPosition;
+  if (baseline.rotation != current.rotation)
+    mask |= NpcFieldRotation;
+  if (baseline.turretAngle != current.turretAngle)
+    mask |= NpcFieldTurret;
+  if (baseline.health != current.health)
+    mask |= NpcFieldHealth;
+  if (baseline.team != current.team || baseline.activated != current.activated)
+    mask |= NpcFieldFlags;
+  return mask;
+}
+
+void StateCodec::writeNpcFields(BitWriter &writer, const QuantizedNpc &npc, std::uint8_t mask) const
+{
+  if (mask & NpcFieldPosition)
+  {
+    writer.write(npc.x, m_positionBits[0]);
+    writer.write(npc.y, m_positionBits[1]);
+  }
+  if (mask & NpcFieldRotation)
+    writer.write(npc.rotation, ANGLE_BITS);
+  if (mask & NpcFieldTurret)
+    writer.write(npc.turretAngle, ANGLE_BITS);
+  if (mask & NpcFieldHealth)
+    writer.write(npc.health, 8);
+  if (mask & NpcFieldFlags)
+  {
+    writer.write(npc.team, 2);
+    writer.write(npc.activated ? 1 : 0, 1);
+  }
+}
+
+void StateCodec::readNpcFields(BitReader &reader, QuantizedNpc &npc, std::uint8_t mask) const
+{
+  if (mask & NpcFieldPosition)
+  {
+    npc.x = reader.read(m_positionBits[0]);
+    npc.y = reader.read(m_positionBits[1]);
+  }
+  if (mask & NpcFieldRotation)
+    npc.rotation = static_cast<std::uint16_t>(reader.read(ANGLE_BITS));
+  if (mask & NpcFieldTurret)
+    npc.turretAngle = static_cast<std::uint16_t>(reader.read(ANGLE_BITS));
+  if (mask & NpcFieldHealth)
+    npc.health = static_cast<std::uint8_t>(reader.read(8));
+  if (mask & NpcFieldFlags)
+  {
+    npc.team = static_cast<std::uint8_t>(reader.read(2));
+    npc.activated = reader.read(1) != 0;
+  }
+}
@@ -0,0 +1,39 @@
+#include "TextureCache.hpp"
+#include <iostream>
+
+TextureCache &TextureCache::getInstance()
+{
+  static TextureCache instance;
+  return instance;
+}
+
+std::shared_ptr<const sf::Texture> TextureCache::acquire(const std::string &path)
+{
+  auto it = m_textures.find(path);
+  if (it != m_textures.end())
+  {
+    if (auto texture = it->second.lock())
+      return texture;
+  }
+
+  auto texture = std::make_shared<sf::Texture>();
+  if (!texture->loadFromFile(path))
+  {
+    std::cerr << "[Texture] Failed to load " << path << std::endl;
+    return nullptr;
+  }
+
+  m_textures[path] = texture;
+  return texture;
+}
+
+std::size_t TextureCache::size() const
+{
+  std::size_t count = 0;
+  for (const auto &[path, texture] : m_textures)
+  {
+    if (!texture.expired())
+      ++count;
+  }
+  return count;
+}
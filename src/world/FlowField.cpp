@@ -0,0 +1,131 @@
+#include "FlowField.hpp"
+#include "Maze.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+void FlowField::build(const WallType *tiles, int rows, int cols, int goal, float destructibleCost)
+{
+  m_tileCount = rows * cols;
+  const std::size_t nodes = static_cast<std::size_t>(m_tileCount) * 2;
+
+  // 数组只在地图尺寸变化时重新分配；之后每次构建只推进代数，旧内容自动失效
+  if (m_stamp.size() != nodes)
+  {
+    m_cost.resize(nodes);
+    m_steps.resize(nodes);
+    m_next.resize(nodes);
+    m_stamp.assign(nodes, 0);
+    m_settled.assign(nodes, 0);
+    m_firstBreach.resize(m_tileCount);
+    m_generation = 0;
+  }
+  if (++m_generation == 0)
+  {
+    // 代数回绕：清零一次，避免与很久以前的标记冲突
+    std::fill(m_stamp.begin(), m_stamp.end(), 0u);
+    std::fill(m_settled.begin(), m_settled.end(), 0u);
+    m_generation = 1;
+  }
+  m_heap.clear();
+  m_goal = goal;
+  m_destructibleCost = destructibleCost;
+
+  if (goal < 0 || goal >= m_tileCount || tiles[goal] == WallType::Solid)
+    return;
+
+  const bool canBreach = destructibleCost >= 0.f;
+  if (tiles[goal] == WallType::Destructible && !canBreach)
+    return;
+
+  auto push = [&](int id, float cost, int steps, int next)
+  {
+    m_stamp[id] = m_generation;
+    m_cost[id] = cost;
+    m_steps[id] = steps;
+    m_next[id] = next;
+    m_heap.push_back({cost, id});
+    std::push_heap(m_heap.begin(), m_heap.end(), std::greater<>());
+  };
+
+  // 只从穿墙标签出发；路径上没有墙时会顺带确定开放标签
+  m_firstBreach[goal] = tiles[goal] == WallType::Destructible ? goal : -1;
+  push(node(goal, FlowLabel::Breach), 0.f, 0, -1);
+
+  // 四个方向
+  const int dr[] = {-1, 0, 1, 0};
+  const int dc[] = {0, 1, 0, -1};
+
+  // 反向 Dijkstra：从 u 扩展到邻居 v，对应正向从 v 走进 u
+  while (!m_heap.empty())
+  {
+    std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<>());
+    auto [cost, id] = m_heap.back();
+    m_heap.pop_back();
+
+    if (m_settled[id] == m_generation || cost > m_cost[id])
+      continue; // 过期条目
+    m_settled[id] = m_generation;
+
+    const int u = id >> 1;
+    bool expandOpen = (id & 1) == static_cast<int>(FlowLabel::Open);
+    const bool expandBreach = !expandOpen;
+
+    // 穿墙最优路径上没有可破坏墙：它同时也是开放最优路径
+    if (expandBreach && m_firstBreach[u] < 0)
+    {
+      const int openId = node(u, FlowLabel::Open);
+      if (m_settled[openId] != m_generation)
+      {
+        m_settled[openId] = m_generation;
+        m_stamp[openId] = m_generation;
+        m_cost[openId] = cost;
+        m_steps[openId] = m_steps[id];
+        m_next[openId] = m_next[id];
+        expandOpen = true;
+      }
+    }
+
+    const int row = u / cols;
+    const int col = u % cols;
+    // 进入 u 的代价：空地/出口=1，可破坏墙=destructibleCost
+    const bool uDestructible = tiles[u] == WallType::Destructible;
+    const float stepCost = cost + (uDestructible ? destructibleCost : 1.f);
+
+    for (int i = 0; i < 4; ++i)
+    {
+      int nr = row + dr[i];
+      int nc = col + dc[i];
+      if (nr < 0 || nr >= rows || nc < 0 || nc >= cols)
+        continue;
+
+      int v = nr * cols + nc;
+      WallType type = tiles[v];
+      if (type == WallType::Solid)
+        continue;
+      const bool vDestructible = type == WallType::Destructible;
+
+      if (expandBreach && (!vDestructible || canBreach))
+      {
+        const int vId = node(v, FlowLabel::Breach);
+        if (m_settled[vId] != m_generation && stepCost < costOf(vId))
+        {
+          m_firstBreach[v] = vDestructible ? v : m_firstBreach[u];
+          push(vId, stepCost, m_steps[id] + 1, u);
+        }
+      }
+
+      // 开放标签只在空地之间传播（u 已确定为空地）
+      if (expandOpen && !vDestructible)
+      {
+        const int vId = node(v, FlowLabel::Open);
+        const int uOpen = node(u, FlowLabel::Open);
+        const float openCost = m_cost[uOpen] + 1.f;
+        if (m_settled[vId] != m_generation && openCost < costOf(vId))
+        {
+          push(vId, openCost, m_steps[uOpen] + 1, u);
+        }
+      }
+    }
+  }
+}
@@ -2,6 +2,43 @@
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
+#include <array>
+#include <limits>
+
+namespace
+{
+  // 8 邻居掩码位：bit0=上, bit1=右上, bit2=右, bit3=右下, bit4=下, bit5=左下, bit6=左, bit7=左上
+  constexpr int NEIGHBOR_DR[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+  constexpr int NEIGHBOR_DC[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+  // 邻居掩码 -> 圆角掩码（bit0..3 = [左上, 右上, 右下, 左下]）
+  // 规则：某个角两侧的正交邻居都不是墙时，该角为圆角
+  constexpr std::array<std::uint8_t, 256> buildCornerLut()
+  {
+    std::array<std::uint8_t, 256> lut{};
+    for (int m = 0; m < 256; ++m)
+    {
+      bool hasTop = (m & 0x01) != 0;
+      bool hasRight = (m & 0x04) != 0;
+      bool hasBottom = (m & 0x10) != 0;
+      bool hasLeft = (m & 0x40) != 0;
+
+      std::uint8_t corners = 0;
+      if (!hasTop && !hasLeft)
+        corners |= 1;
+      if (!hasTop && !hasRight)
+        corners |= 2;
+      if (!hasBottom && !hasRight)
+        corners |= 4;
+      if (!hasBottom && !hasLeft)
+        corners |= 8;
+      lut[m] = corners;
+    }
+    return lut;
+  }
+
+  constexpr std::array<std::uint8_t, 256> CORNER_LUT = buildCornerLut();
+}
 
 Maze::Maze()
 {
@@ -12,110 +49,111 @@ void Maze::loadFromString(const std::vector<std::string> &map)
   if (map.empty())
     return;
 
-  // 保存原始迷宫数据用于网络传输
-  m_mazeData = map;
+  // 统一先编码为压缩格式（同时用于网络传输和存档），再从压缩数据加载
+  std::vector<std::uint8_t> packed;
+  MazeCodec::encode(map, packed);
+  m_packedData = std::move(packed);
+  loadFromPacked(m_packedData);
+}
 
-  m_rows = static_cast<int>(map.size());
-  m_cols = 0;
-  for (const auto &row : map)
-  {
-    m_cols = std::max(m_cols, static_cast<int>(row.size()));
-  }
+bool Maze::loadFromFile(const std::string &path)
+{
+  std::vector<std::uint8_t> packed;
+  if (!MazeCodec::loadFromFile(path, packed))
+    return false;
+
+  m_packedData = std::move(packed);
+  return loadFromPacked(m_packedData);
+}
 
-  m_walls.clear();
-  m_walls.resize(m_rows, std::vector<Wall>(m_cols));
+bool Maze::loadFromPacked(std::span<const std::uint8_t> packed)
+{
+  MazeCodec::Header header;
+  if (!MazeCodec::validate(packed, header))
+    return false;
+
+  // 保存压缩数据用于网络传输（数据本身就是 m_packedData 时不复制）
+  if (packed.data() != m_packedData.data())
+    m_packedData.assign(packed.begin(), packed.end());
+
+  m_rows = header.rows;
+  m_cols = header.cols;
+
+  const std::size_t tileCount = static_cast<std::size_t>(m_rows) * m_cols;
+  m_tileType.assign(tileCount, WallType::None);
+  m_tileAttribute.assign(tileCount, WallAttribute::None);
+  m_tileHealth.assign(tileCount, 0.f);
+  m_tileCorners.assign(tileCount, 0xFF); // 无效掩码，保证首次计算圆角时每个墙格都会烘焙
+  m_tileDirty.assign(tileCount, 0);
+  m_dirtyTiles.clear();
+  m_renderer.reset(m_rows, m_cols, m_tileSize, WALL_CORNER_RADIUS);
+  ++m_tileVersion;
+  m_flowFields.clear(); // 敌人持有的旧流场仍然有效，会因版本不一致而重新规划
   m_enemySpawnPoints.clear();
   m_spawn1Position = {0.f, 0.f};
   m_spawn2Position = {0.f, 0.f};
 
-  for (int r = 0; r < m_rows; ++r)
+  auto cellCenter = [this](MazeCodec::Cell cell)
   {
-    for (int c = 0; c < static_cast<int>(map[r].size()); ++c)
+    return sf::Vector2f(cell.x * m_tileSize + m_tileSize / 2.f, cell.y * m_tileSize + m_tileSize / 2.f);
+  };
+
+  // 起点、出口和出生点记在头部
+  if (header.start.valid())
+    m_startPosition = cellCenter(header.start);
+  if (header.exit.valid())
+    m_exitPosition = cellCenter(header.exit);
+  if (header.spawn1.valid())
+    m_spawn1Position = cellCenter(header.spawn1);
+  if (header.spawn2.valid())
+    m_spawn2Position = cellCenter(header.spawn2);
+
+  // 逐段解码，整段写入格子数组
+  MazeCodec::RunReader reader(m_packedData, header);
+  MazeCodec::Run run;
+  while (reader.next(run))
+  {
+    const int first = tileIndex(run.row, run.col);
+    const int last = first + run.length;
+
+    switch (run.tile)
     {
-      char ch = map[r][c];
-      Wall &wall = m_walls[r][c];
+    case MazeCodec::Tile::Solid: // 不可破坏墙
+      std::fill(m_tileType.begin() + first, m_tileType.begin() + last, WallType::Solid);
+      break;
 
-      float x = c * m_tileSize;
-      float y = r * m_tileSize;
+    case MazeCodec::Tile::Destructible: // 可破坏墙（普通）
+    case MazeCodec::Tile::Gold:         // 金色墙 - 打掉获得2金币
+    case MazeCodec::Tile::Heal:         // 治疗墙 - 恢复25%血量
+    {
+      const WallAttribute attribute = run.tile == MazeCodec::Tile::Gold   ? WallAttribute::Gold
+                                      : run.tile == MazeCodec::Tile::Heal ? WallAttribute::Heal
+                                                                          : WallAttribute::None;
+      std::fill(m_tileType.begin() + first, m_tileType.begin() + last, WallType::Destructible);
+      std::fill(m_tileAttribute.begin() + first, m_tileAttribute.begin() + last, attribute);
+      std::fill(m_tileHealth.begin() + first, m_tileHealth.begin() + last, WALL_MAX_HEALTH);
+      break;
+    }
 
-      wall.shape.setSize({m_tileSize - 2.f, m_tileSize - 2.f});
-      wall.shape.setCornerRadius(WALL_CORNER_RADIUS);
-      wall.shape.setPosition({x + 1.f, y + 1.f});
+    case MazeCodec::Tile::Exit: // 出口
+      std::fill(m_tileType.begin() + first, m_tileType.begin() + last, WallType::Exit);
+      break;
 
-      switch (ch)
+    case MazeCodec::Tile::Enemy: // 敌人位置
+      for (int c = run.col; c < run.col + run.length; ++c)
       {
-      case '#': // 不可破坏墙
-        wall.type = WallType::Solid;
-        wall.shape.setFillColor(m_solidColor);
-        wall.shape.setOutlineColor(sf::Color(60, 60, 60));
-        wall.shape.setOutlineThickness(1.f);
-        break;
-
-      case '*': // 可破坏墙（普通）
-        wall.type = WallType::Destructible;
-        wall.attribute = WallAttribute::None;
-        wall.health = 100.f;
-        wall.maxHealth = 100.f;
-        wall.shape.setFillColor(m_destructibleColor);
-        wall.shape.setOutlineColor(sf::Color(100, 60, 20));
-        wall.shape.setOutlineThickness(1.f);
-        break;
-
-      case 'G': // 金色墙 - 打掉获得2金币
-        wall.type = WallType::Destructible;
-        wall.attribute = WallAttribute::Gold;
-        wall.health = 100.f;
-        wall.maxHealth = 100.f;
-        wall.shape.setFillColor(m_goldWallColor);
-        wall.shape.setOutlineColor(sf::Color(220, 170, 30)); // 金色边框
-        wall.shape.setOutlineThickness(1.f);
-        break;
-
-      case 'H': // 治疗墙 - 恢复25%血量
-        wall.type = WallType::Destructible;
-        wall.attribute = WallAttribute::Heal;
-        wall.health = 100.f;
-        wall.maxHealth = 100.f;
-        wall.shape.setFillColor(m_healWallColor);
-        wall.shape.setOutlineColor(sf::Color(50, 140, 220)); // 蓝色边框
-        wall.shape.setOutlineThickness(1.f);
-        break;
-
-      case 'S': // 起点
-        wall.type = WallType::None;
-        m_startPosition = {x + m_tileSize / 2.f, y + m_tileSize / 2.f};
-        break;
-
-      case 'E': // 出口
-        wall.type = WallType::Exit;
-        wall.shape.setFillColor(m_exitColor);
-        m_exitPosition = {x + m_tileSize / 2.f, y + m_tileSize / 2.f};
-        break;
-
-      case 'X': // 敌人位置
-        wall.type = WallType::None;
-        m_enemySpawnPoints.push_back({x + m_tileSize / 2.f, y + m_tileSize / 2.f});
-        break;
-
-      case '1': // 多人模式出生点1
-        wall.type = WallType::None;
-        m_spawn1Position = {x + m_tileSize / 2.f, y + m_tileSize / 2.f};
-        break;
-
-      case '2': // 多人模式出生点2
-        wall.type = WallType::None;
-        m_spawn2Position = {x + m_tileSize / 2.f, y + m_tileSize / 2.f};
-        break;
-
-      default: // 空地
-        wall.type = WallType::None;
-        break;
+        m_enemySpawnPoints.push_back(cellCenter({static_cast<std::uint16_t>(c), static_cast<std::uint16_t>(run.row)}));
       }
+      break;
+
+    default: // 空地
+      break;
     }
   }
 
-  // 计算每个墙体的圆角
+  // 计算每个墙体的圆角（同时烘焙墙体几何）
   calculateRoundedCorners();
+  return true;
 }
 
 void Maze::generateRandomMaze(int width, int height, unsigned int seed, int enemyCount, bool multiplayerMode, bool escapeMode)
@@ -135,70 +173,53 @@ void Maze::generateRandomMaze(int width, int height, unsigned int seed, int enem
   loadFromString(mazeData);
 }
 
-void Maze::update(float dt)
+void Maze::update(float dt, const sf::View &view)
 {
   (void)dt;
-  // 更新可破坏墙的颜色（根据血量）
-  for (int r = 0; r < m_rows; ++r)
+  // 没有墙体受伤时不做任何事
+  if (m_dirtyTiles.empty())
+    return;
+
+  // 只给视图内的脏格子重新着色，视图外的留在列表里等进入视野
+  TileRange visible = getVisibleTiles(view);
+  std::size_t kept = 0;
+  for (int idx : m_dirtyTiles)
   {
-    for (int c = 0; c < m_cols; ++c)
+    int r = idx / m_cols;
+    int c = idx % m_cols;
+    if (r < visible.minRow || r > visible.maxRow || c < visible.minCol || c > visible.maxCol)
     {
-      Wall &wall = m_walls[r][c];
-      if (wall.type == WallType::Destructible)
-      {
-        float healthRatio = wall.health / wall.maxHealth;
-        sf::Color color;
-
-        // 根据墙体属性选择对应的颜色插值
-        switch (wall.attribute)
-        {
-        case WallAttribute::Gold:
-        {
-          // 金色墙：从深金色到亮金色
-          sf::Color dark(180, 140, 30);
-          color.r = static_cast<std::uint8_t>(dark.r + (m_goldWallColor.r - dark.r) * healthRatio);
-          color.g = static_cast<std::uint8_t>(dark.g + (m_goldWallColor.g - dark.g) * healthRatio);
-          color.b = static_cast<std::uint8_t>(dark.b + (m_goldWallColor.b - dark.b) * healthRatio);
-          break;
-        }
-        case WallAttribute::Heal:
-        {
-          // 蓝色墙：从深蓝色到亮蓝色
-          sf::Color dark(40, 100, 180);
-          color.r = static_cast<std::uint8_t>(dark.r + (m_healWallColor.r - dark.r) * healthRatio);
-          color.g = static_cast<std::uint8_t>(dark.g + (m_healWallColor.g - dark.g) * healthRatio);
-          color.b = static_cast<std::uint8_t>(dark.b + (m_healWallColor.b - dark.b) * healthRatio);
-          break;
-        }
-        default: // WallAttribute::None - 普通可破坏墙（棕色）
-          color.r = static_cast<std::uint8_t>(m_destructibleDamagedColor.r +
-                                              (m_destructibleColor.r - m_destructibleDamagedColor.r) * healthRatio);
-          color.g = static_cast<std::uint8_t>(m_destructibleDamagedColor.g +
-                                              (m_destructibleColor.g - m_destructibleDamagedColor.g) * healthRatio);
-          color.b = static_cast<std::uint8_t>(m_destructibleDamagedColor.b +
-                                              (m_destructibleColor.b - m_destructibleDamagedColor.b) * healthRatio);
-          break;
-        }
+      m_dirtyTiles[kept++] = idx;
+      continue;
+    }
 
-        wall.shape.setFillColor(color);
-      }
+    m_tileDirty[idx] = 0;
+    if (m_tileType[idx] == WallType::Destructible)
+    {
+      m_renderer.setTileFill(r, c, tileFillColor(idx));
     }
   }
+  m_dirtyTiles.resize(kept);
 }
 
 void Maze::draw(sf::RenderWindow &window) const
 {
-  for (int r = 0; r < m_rows; ++r)
-  {
-    for (int c = 0; c < m_cols; ++c)
-    {
-      const Wall &wall = m_walls[r][c];
-      if (wall.type != WallType::None)
-      {
-        window.draw(wall.shape);
-      }
-    }
-  }
+  // 墙体按分块烘焙，只绘制与当前视图相交的分块
+  m_renderer.draw(window, getVisibleTiles(window.getView()));
+}
+
+TileRange Maze::getVisibleTiles(const sf::View &view, int margin) const
+{
+  sf::Vector2f halfSize = view.getSize() / 2.f;
+  sf::Vector2f topLeft = view.getCenter() - halfSize;
+  sf::Vector2f bottomRight = view.getCenter() + halfSize;
+
+  TileRange range;
+  range.minCol = std::max(0, static_cast<int>(std::floor(topLeft.x / m_tileSize)) - margin);
+  range.minRow = std::max(0, static_cast<int>(std::floor(topLeft.y / m_tileSize)) - margin);
+  range.maxCol = std::min(m_cols - 1, static_cast<int>(std::floor(bottomRight.x / m_tileSize)) + margin);
+  range.maxRow = std::min(m_rows - 1, static_cast<int>(std::floor(bottomRight.y / m_tileSize)) + margin);
+  return range;
 }
 
 bool Maze::checkCollision(sf::Vector2f position, float radius) const
@@ -213,8 +234,8 @@ bool Maze::checkCollision(sf::Vector2f position, float radius) const
   {
     for (int c = minC; c <= maxC; ++c)
     {
-      const Wall &wall = m_walls[r][c];
-      if (wall.type == WallType::Solid || wall.type == WallType::Destructible)
+      const int idx = tileIndex(r, c);
+      if (m_tileType[idx] == WallType::Solid || m_tileType[idx] == WallType::Destructible)
       {
         // 选择性圆角矩形与圆形碰撞检测
         float wallLeft = c * m_tileSize + 1.f; // 考虑1像素偏移
@@ -247,7 +268,7 @@ bool Maze::checkCollision(sf::Vector2f position, float radius) const
         else if (inLeftZone && inBottomZone)
           cornerIndex = 3;
 
-        if (cornerIndex >= 0 && wall.roundedCorners[cornerIndex])
+        if (cornerIndex >= 0 && (m_tileCorners[idx] & (1u << cornerIndex)))
         {
           // 这个角是圆角 - 使用圆形碰撞检测
           float cornerCenterX = inLeftZone ? innerLeft : innerRight;
@@ -291,18 +312,22 @@ bool Maze::bulletHit(sf::Vector2f bulletPos, float damage)
   if (r < 0 || r >= m_rows || c < 0 || c >= m_cols)
     return false;
 
-  Wall &wall = m_walls[r][c];
+  const int idx = tileIndex(r, c);
 
-  if (wall.type == WallType::Solid)
+  if (m_tileType[idx] == WallType::Solid)
   {
     return true; // 击中不可破坏墙
   }
-  else if (wall.type == WallType::Destructible)
+  else if (m_tileType[idx] == WallType::Destructible)
   {
-    wall.health -= damage;
-    if (wall.health <= 0)
+    m_tileHealth[idx] -= damage;
+    if (m_tileHealth[idx] <= 0)
     {
-      wall.type = WallType::None; // 墙被摧毁
+      destroyTile(r, c); // 墙被摧毁
+    }
+    else
+    {
+      markDirty(idx);
     }
     return true;
   }
@@ -320,10 +345,10 @@ WallDestroyResult Maze::bulletHitWithResult(sf::Vector2f bulletPos, float damage
   if (r < 0 || r >= m_rows || c < 0 || c >= m_cols)
     return result;
 
-  Wall &wall = m_walls[r][c];
+  const int idx = tileIndex(r, c);
 
   // 如果是不可破坏墙，视为命中但无摧毁效果
-  if (wall.type == WallType::Solid)
+  if (m_tileType[idx] == WallType::Solid)
   {
     result.destroyed = false;
     result.attribute = WallAttribute::None;
@@ -333,25 +358,26 @@ WallDestroyResult Maze::bulletHitWithResult(sf::Vector2f bulletPos, float damage
     return result;
   }
 
-  if (wall.type == WallType::Destructible)
+  if (m_tileType[idx] == WallType::Destructible)
   {
-    wall.health -= damage;
+    m_tileHealth[idx] -= damage;
 
-    if (wall.health <= 0)
+    if (m_tileHealth[idx] <= 0)
     {
       // 记录摧毁信息
       result.destroyed = true;
-      result.attribute = wall.attribute;
+      result.attribute = m_tileAttribute[idx];
       result.position = {c * m_tileSize + m_tileSize / 2.f, r * m_tileSize + m_tileSize / 2.f};
       result.gridX = c;
       result.gridY = r;
 
       // 清除当前墙格
-      wall.type = WallType::None;
+      destroyTile(r, c);
     }
     else
     {
       // 受伤但未摧毁
+      markDirty(idx);
       result.destroyed = false;
       result.attribute = WallAttribute::None;
       result.position = {c * m_tileSize + m_tileSize / 2.f, r * m_tileSize + m_tileSize / 2.f};
@@ -370,37 +396,38 @@ WallDestroyResult Maze::applyWallDamage(int row, int col, float damage, bool for
 {
   WallDestroyResult result;
 
-  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols)
+  if (!inBounds(row, col))
     return result;
 
-  Wall &wall = m_walls[row][col];
+  const int idx = tileIndex(row, col);
 
-  if (wall.type == WallType::Destructible)
+  if (m_tileType[idx] == WallType::Destructible)
   {
     if (forceDestroy)
     {
       // 强制摧毁（用于同步已确定摧毁的墙）
       result.destroyed = true;
-      result.attribute = wall.attribute;
+      result.attribute = m_tileAttribute[idx];
       result.position = {col * m_tileSize + m_tileSize / 2.f, row * m_tileSize + m_tileSize / 2.f};
       result.gridX = col;
       result.gridY = row;
-      wall.type = WallType::None;
+      destroyTile(row, col);
     }
     else
     {
-      wall.health -= damage;
-      if (wall.health <= 0)
+      m_tileHealth[idx] -= damage;
+      if (m_tileHealth[idx] <= 0)
       {
         result.destroyed = true;
-        result.attribute = wall.attribute;
+        result.attribute = m_tileAttribute[idx];
         result.position = {col * m_tileSize + m_tileSize / 2.f, row * m_tileSize + m_tileSize / 2.f};
         result.gridX = col;
         result.gridY = row;
-        wall.type = WallType::None;
+        destroyTile(row, col);
       }
       else
       {
+        markDirty(idx);
         result.destroyed = false;
         result.attribute = WallAttribute::None;
         result.position = {col * m_tileSize + m_tileSize / 2.f, row * m_tileSize + m_tileSize / 2.f};
@@ -423,9 +450,9 @@ bool Maze::isAtExit(sf::Vector2f position, float radius) const
 
 bool Maze::isWalkable(int row, int col) const
 {
-  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols)
+  if (!inBounds(row, col))
     return false;
-  WallType type = m_walls[row][col].type;
+  WallType type = m_tileType[tileIndex(row, col)];
   return type == WallType::None || type == WallType::Exit;
 }
 
@@ -438,10 +465,8 @@ bool Maze::canPlaceWall(sf::Vector2f worldPos) const
   if (r < 0 || r >= m_rows || c < 0 || c >= m_cols)
     return false;
 
-  const Wall &wall = m_walls[r][c];
-
   // 只能在空地上放置
-  if (wall.type != WallType::None)
+  if (m_tileType[tileIndex(r, c)] != WallType::None)
     return false;
 
   // 不能放在起点
@@ -466,26 +491,19 @@ bool Maze::placeWall(sf::Vector2f worldPos)
   int c = static_cast<int>(worldPos.x / m_tileSize);
   int r = static_cast<int>(worldPos.y / m_tileSize);
 
-  Wall &wall = m_walls[r][c];
+  const int idx = tileIndex(r, c);
 
   // 设置为可破坏的棕色墙
-  wall.type = WallType::Destructible;
-  wall.attribute = WallAttribute::None;
-  wall.health = 100.f;
-  wall.maxHealth = 100.f;
-
-  // 设置形状
-  float x = c * m_tileSize;
-  float y = r * m_tileSize;
-  wall.shape.setSize({m_tileSize - 2.f, m_tileSize - 2.f});
-  wall.shape.setCornerRadius(WALL_CORNER_RADIUS);
-  wall.shape.setPosition({x + 1.f, y + 1.f});
-  wall.shape.setFillColor(m_destructibleColor);
-  wall.shape.setOutlineColor(sf::Color(100, 60, 20));
-  wall.shape.setOutlineThickness(1.f);
-
-  // 重新计算圆角
-  calculateRoundedCorners();
+  m_tileType[idx] = WallType::Destructible;
+  m_tileAttribute[idx] = WallAttribute::None;
+  m_tileHealth[idx] = WALL_MAX_HEALTH;
+  ++m_tileVersion;
+
+  // 无效掩码保证下面的圆角更新会把该格子写入渲染层（被摧毁过的格子复用原来的顶点槽）
+  m_tileCorners[idx] = 0xFF;
+
+  // 只重新计算该格子及邻居的圆角
+  updateCornersAround(r, c);
 
   return true;
 }
@@ -500,433 +518,323 @@ sf::Vector2f Maze::gridToWorld(GridPos grid) const
   return {grid.x * m_tileSize + m_tileSize / 2.f, grid.y * m_tileSize + m_tileSize / 2.f};
 }
 
-std::vector<sf::Vector2f> Maze::findPath(sf::Vector2f start, sf::Vector2f target) const
+std::shared_ptr<const FlowField> Maze::getFlowField(sf::Vector2f target, float destructibleCost) const
 {
-  GridPos startGrid = worldToGrid(start);
-  GridPos targetGrid = worldToGrid(target);
+  const int goal = gridToIndex(worldToGrid(target));
+  const auto now = std::chrono::steady_clock::now();
 
-  // 如果起点或终点不可通行，返回空路径
-  if (!isWalkable(startGrid.y, startGrid.x) || !isWalkable(targetGrid.y, targetGrid.x))
+  // 查找同一目标、同一代价的流场；没有则复用过期的条目，都在使用中才新增
+  FlowFieldEntry *entry = nullptr;
+  FlowFieldEntry *reusable = nullptr;
+  for (FlowFieldEntry &candidate : m_flowFields)
   {
-    return {};
+    if (candidate.field->getGoal() == goal && candidate.field->getDestructibleCost() == destructibleCost)
+    {
+      entry = &candidate;
+      break;
+    }
+    if (!reusable && (candidate.tileVersion != m_tileVersion || now - candidate.lastUse > FLOW_FIELD_TTL))
+    {
+      reusable = &candidate;
+    }
   }
 
-  // A* 算法
-  auto heuristic = [](GridPos a, GridPos b) -> float
-  {
-    return static_cast<float>(std::abs(a.x - b.x) + std::abs(a.y - b.y));
-  };
-
-  struct Node
+  bool rebuild = false;
+  if (!entry)
   {
-    GridPos pos;
-    float gCost; // 从起点到当前节点的代价
-    float fCost; // gCost + heuristic
-
-    bool operator>(const Node &other) const { return fCost > other.fCost; }
-  };
-
-  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> openSet;
-  std::unordered_map<GridPos, GridPos, GridPosHash> cameFrom;
-  std::unordered_map<GridPos, float, GridPosHash> gScore;
-
-  openSet.push({startGrid, 0.f, heuristic(startGrid, targetGrid)});
-  gScore[startGrid] = 0.f;
-
-  // 四个方向
-  const int dx[] = {0, 1, 0, -1};
-  const int dy[] = {-1, 0, 1, 0};
-
-  while (!openSet.empty())
-  {
-    Node current = openSet.top();
-    openSet.pop();
-
-    if (current.pos == targetGrid)
+    if (reusable)
     {
-      // 重建路径
-      std::vector<sf::Vector2f> path;
-      GridPos curr = targetGrid;
-      while (curr != startGrid)
-      {
-        path.push_back(gridToWorld(curr));
-        curr = cameFrom[curr];
-      }
-      std::reverse(path.begin(), path.end());
-      return path;
+      entry = reusable;
     }
-
-    // 检查是否已经有更好的路径到达这个节点
-    if (gScore.count(current.pos) && current.gCost > gScore[current.pos])
+    else
     {
-      continue;
+      m_flowFields.push_back({0, now, std::make_shared<FlowField>()});
+      entry = &m_flowFields.back();
     }
+    rebuild = true;
+  }
 
-    for (int i = 0; i < 4; ++i)
-    {
-      GridPos neighbor = {current.pos.x + dx[i], current.pos.y + dy[i]};
-
-      if (!isWalkable(neighbor.y, neighbor.x))
-        continue;
-
-      float tentativeG = current.gCost + 1.f;
-
-      if (!gScore.count(neighbor) || tentativeG < gScore[neighbor])
-      {
-        cameFrom[neighbor] = current.pos;
-        gScore[neighbor] = tentativeG;
-        float fCost = tentativeG + heuristic(neighbor, targetGrid);
-        openSet.push({neighbor, tentativeG, fCost});
-      }
-    }
+  // 新目标或地图已变化时重建（持有旧流场的敌人会通过目标/版本检查发现并重新规划）
+  if (rebuild || entry->tileVersion != m_tileVersion)
+  {
+    entry->field->build(m_tileType.data(), m_rows, m_cols, goal, destructibleCost);
+    entry->tileVersion = m_tileVersion;
   }
 
-  // 没有找到路径
-  return {};
+  entry->lastUse = now;
+  return entry->field;
 }
 
 bool Maze::isDestructibleWall(int row, int col) const
 {
-  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols)
+  if (!inBounds(row, col))
     return false;
-  return m_walls[row][col].type == WallType::Destructible;
+  return m_tileType[tileIndex(row, col)] == WallType::Destructible;
 }
 
-Maze::PathResult Maze::findPathThroughDestructible(sf::Vector2f start, sf::Vector2f target, float destructibleCost) const
+Maze::RayHit Maze::raycast(sf::Vector2f start, sf::Vector2f end, bool throughDestructible) const
 {
-  PathResult result;
-
-  GridPos startGrid = worldToGrid(start);
-  GridPos targetGrid = worldToGrid(target);
-
-  // 检查起点和终点是否有效（起点必须可通行，终点可以是空地或可破坏墙）
-  if (!isWalkable(startGrid.y, startGrid.x))
-  {
-    return result;
-  }
-
-  // 终点如果是不可破坏墙则无法到达
-  if (targetGrid.y >= 0 && targetGrid.y < m_rows && targetGrid.x >= 0 && targetGrid.x < m_cols)
-  {
-    if (m_walls[targetGrid.y][targetGrid.x].type == WallType::Solid)
-    {
-      return result;
-    }
-  }
-
-  // A* 算法（将可破坏墙视为高代价但可通行）
-  auto heuristic = [](GridPos a, GridPos b) -> float
-  {
-    return static_cast<float>(std::abs(a.x - b.x) + std::abs(a.y - b.y));
-  };
-
-  struct Node
-  {
-    GridPos pos;
-    float gCost;
-    float fCost;
-
-    bool operator>(const Node &other) const { return fCost > other.fCost; }
-  };
-
-  std::priority_queue<Node, std::vector<Node>, std::greater<Node>> openSet;
-  std::unordered_map<GridPos, GridPos, GridPosHash> cameFrom;
-  std::unordered_map<GridPos, float, GridPosHash> gScore;
-
-  openSet.push({startGrid, 0.f, heuristic(startGrid, targetGrid)});
-  gScore[startGrid] = 0.f;
+  RayHit firstDestructible;
+  const sf::Vector2f dir = end - start;
+
+  int x = static_cast<int>(std::floor(start.x / m_tileSize));
+  int y = static_cast<int>(std::floor(start.y / m_tileSize));
+  const int endX = static_cast<int>(std::floor(end.x / m_tileSize));
+  const int endY = static_cast<int>(std::floor(end.y / m_tileSize));
+
+  const int stepX = dir.x > 0.f ? 1 : (dir.x < 0.f ? -1 : 0);
+  const int stepY = dir.y > 0.f ? 1 : (dir.y < 0.f ? -1 : 0);
+
+  // t 为线段参数（0 = start, 1 = end）
+  // tMax：到达下一条竖线/横线时的 t；tDelta：穿过一整个格子需要的 t
+  const float inf = std::numeric_limits<float>::infinity();
+  float tDeltaX = stepX != 0 ? m_tileSize / std::abs(dir.x) : inf;
+  float tDeltaY = stepY != 0 ? m_tileSize / std::abs(dir.y) : inf;
+  float tMaxX = stepX > 0 ? ((x + 1) * m_tileSize - start.x) / dir.x
+                          : (stepX < 0 ? (x * m_tileSize - start.x) / dir.x : inf);
+  float tMaxY = stepY > 0 ? ((y + 1) * m_tileSize - start.y) / dir.y
+                          : (stepY < 0 ? (y * m_tileSize - start.y) / dir.y : inf);
+
+  // 线段穿过的格子数是确定的，按步数终止，避免浮点误差导致越过终点
+  int remaining = std::abs(endX - x) + std::abs(endY - y);
+  float t = 0.f;
 
-  const int dx[] = {0, 1, 0, -1};
-  const int dy[] = {-1, 0, 1, 0};
-
-  while (!openSet.empty())
+  while (true)
   {
-    Node current = openSet.top();
-    openSet.pop();
-
-    if (current.pos == targetGrid)
+    // 地图外的格子视为空地
+    if (inBounds(y, x))
     {
-      // 重建路径并查找第一个可破坏墙
-      std::vector<sf::Vector2f> path;
-      GridPos curr = targetGrid;
-
-      // 先收集所有路径点（从终点到起点）
-      std::vector<GridPos> gridPath;
-      while (curr != startGrid)
-      {
-        gridPath.push_back(curr);
-        curr = cameFrom[curr];
-      }
-
-      // 反转得到从起点到终点的顺序
-      std::reverse(gridPath.begin(), gridPath.end());
-
-      // 转换为世界坐标并查找第一个可破坏墙
-      for (const auto &gridPos : gridPath)
+      WallType type = m_tileType[tileIndex(y, x)];
+      if (type == WallType::Solid || type == WallType::Destructible)
       {
-        path.push_back(gridToWorld(gridPos));
-
-        // 检查是否是可破坏墙（且还没找到第一个）
-        if (!result.hasDestructibleWall && isDestructibleWall(gridPos.y, gridPos.x))
-        {
-          result.hasDestructibleWall = true;
-          result.firstDestructibleWallPos = gridToWorld(gridPos);
-          result.firstDestructibleWallGrid = gridPos;
-        }
+        RayHit hit{type, {x, y}, start + dir * t};
+        if (type == WallType::Solid || !throughDestructible)
+          return hit;
+        if (firstDestructible.type == WallType::None)
+          firstDestructible = hit;
       }
-
-      result.path = path;
-      return result;
     }
 
-    if (gScore.count(current.pos) && current.gCost > gScore[current.pos])
+    if (remaining-- <= 0)
+      break;
+
+    // 走向更近的那条格线
+    if (tMaxX < tMaxY)
     {
-      continue;
+      t = tMaxX;
+      tMaxX += tDeltaX;
+      x += stepX;
     }
-
-    for (int i = 0; i < 4; ++i)
+    else
     {
-      GridPos neighbor = {current.pos.x + dx[i], current.pos.y + dy[i]};
-
-      // 边界检查
-      if (neighbor.y < 0 || neighbor.y >= m_rows || neighbor.x < 0 || neighbor.x >= m_cols)
-        continue;
-
-      WallType neighborType = m_walls[neighbor.y][neighbor.x].type;
-
-      // 不可破坏墙不能通过
-      if (neighborType == WallType::Solid)
-        continue;
-
-      // 计算移动代价：空地/出口=1，可破坏墙=destructibleCost
-      float moveCost = 1.f;
-      if (neighborType == WallType::Destructible)
-      {
-        moveCost = destructibleCost;
-      }
-
-      float tentativeG = current.gCost + moveCost;
-
-      if (!gScore.count(neighbor) || tentativeG < gScore[neighbor])
-      {
-        cameFrom[neighbor] = current.pos;
-        gScore[neighbor] = tentativeG;
-        float fCost = tentativeG + heuristic(neighbor, targetGrid);
-        openSet.push({neighbor, tentativeG, fCost});
-      }
+      t = tMaxY;
+      tMaxY += tDeltaY;
+      y += stepY;
     }
   }
 
-  return result; // 空路径
+  return firstDestructible;
 }
 
 int Maze::checkLineOfSight(sf::Vector2f start, sf::Vector2f end) const
 {
-  // 使用 Bresenham 线段算法检查视线
   // 返回值：0 = 无阻挡, 1 = 有可拆墙阻挡, 2 = 有不可拆墙阻挡
+  // 穿过可拆墙继续检查后面是否有不可拆墙
+  RayHit hit = raycast(start, end, true);
+  if (hit.type == WallType::Solid)
+    return 2;
+  if (hit.type == WallType::Destructible)
+    return 1;
+  return 0;
+}
 
-  GridPos startGrid = worldToGrid(start);
-  GridPos endGrid = worldToGrid(end);
-
-  int x0 = startGrid.x, y0 = startGrid.y;
-  int x1 = endGrid.x, y1 = endGrid.y;
-
-  int dx = std::abs(x1 - x0);
-  int dy = std::abs(y1 - y0);
-  int sx = x0 < x1 ? 1 : -1;
-  int sy = y0 < y1 ? 1 : -1;
-  int err = dx - dy;
+int Maze::checkBulletPath(sf::Vector2f start, sf::Vector2f target) const
+{
+  sf::Vector2f direction = target - start;
+  if (direction.x * direction.x + direction.y * direction.y < 1.f)
+    return 0; // 起点和终点太近
 
-  int result = 0; // 无阻挡
+  // 子弹碰到第一面墙就停止，所以只看第一个阻挡
+  RayHit hit = raycast(start, target);
+  if (hit.type == WallType::Solid)
+    return 2; // 会先命中不可破坏墙
+  if (hit.type == WallType::Destructible)
+    return 1; // 会先命中可破坏墙
+  return 0;
+}
 
-  while (true)
+sf::Vector2f Maze::getFirstBlockedPosition(sf::Vector2f start, sf::Vector2f end) const
+{
+  // 找到视线上第一个被阻挡的格子
+  RayHit hit = raycast(start, end);
+  if (hit.type != WallType::None)
   {
-    // 检查当前格子
-    if (y0 >= 0 && y0 < m_rows && x0 >= 0 && x0 < m_cols)
-    {
-      WallType type = m_walls[y0][x0].type;
-      if (type == WallType::Solid)
-      {
-        return 2; // 不可拆墙阻挡
-      }
-      else if (type == WallType::Destructible)
-      {
-        result = 1; // 可拆墙阻挡（继续检查是否有不可拆墙）
-      }
-    }
-
-    if (x0 == x1 && y0 == y1)
-      break;
-
-    int e2 = 2 * err;
-    if (e2 > -dy)
-    {
-      err -= dy;
-      x0 += sx;
-    }
-    if (e2 < dx)
-    {
-      err += dx;
-      y0 += sy;
-    }
+    return gridToWorld(hit.cell);
   }
 
-  return result;
+  return end; // 没有阻挡，返回目标位置
 }
 
-int Maze::checkBulletPath(sf::Vector2f start, sf::Vector2f target) const
+bool Maze::isWall(int row, int col) const
 {
-  // 使用射线步进法更精确地检测子弹路径
-  // 每次步进一小段距离，检查是否碰到墙壁
+  if (!inBounds(row, col))
+    return true; // 边界外视为墙
 
-  sf::Vector2f direction = target - start;
-  float distance = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+  WallType type = m_tileType[tileIndex(row, col)];
+  return type == WallType::Solid || type == WallType::Destructible;
+}
 
-  if (distance < 1.f)
-    return 0; // 起点和终点太近
+std::uint8_t Maze::neighborMask(int row, int col) const
+{
+  std::uint8_t mask = 0;
+  for (int i = 0; i < 8; ++i)
+  {
+    if (isWall(row + NEIGHBOR_DR[i], col + NEIGHBOR_DC[i]))
+      mask |= static_cast<std::uint8_t>(1u << i);
+  }
+  return mask;
+}
 
-  // 归一化方向
-  direction /= distance;
+void Maze::updateTileCorners(int row, int col)
+{
+  if (!inBounds(row, col))
+    return;
 
-  // 步进大小（小于格子大小的一半，确保不会跳过墙壁）
-  const float stepSize = m_tileSize * 0.05f;
-  int steps = static_cast<int>(distance / stepSize) + 1;
+  const int idx = tileIndex(row, col);
 
-  int result = 0; // 默认无阻挡
+  // 只处理墙体
+  WallType type = m_tileType[idx];
+  if (type != WallType::Solid && type != WallType::Destructible && type != WallType::Exit)
+    return;
 
-  for (int i = 1; i <= steps; ++i)
+  // 查表得到圆角掩码，有变化时重新烘焙该格子
+  std::uint8_t mask = CORNER_LUT[neighborMask(row, col)];
+  if (m_tileCorners[idx] != mask)
   {
-    float t = std::min(static_cast<float>(i) * stepSize, distance);
-    sf::Vector2f checkPos = start + direction * t;
-
-    GridPos grid = worldToGrid(checkPos);
-
-    // 边界检查
-    if (grid.y < 0 || grid.y >= m_rows || grid.x < 0 || grid.x >= m_cols)
-      continue;
-
-    WallType type = m_walls[grid.y][grid.x].type;
+    m_tileCorners[idx] = mask;
+    refreshTile(row, col);
+  }
+}
 
-    if (type == WallType::Solid)
+void Maze::updateCornersAround(int row, int col)
+{
+  // 一个格子变化只会影响自身和 8 个邻居的圆角
+  for (int r = row - 1; r <= row + 1; ++r)
+  {
+    for (int c = col - 1; c <= col + 1; ++c)
     {
-      return 2; // 会先命中不可破坏墙
+      updateTileCorners(r, c);
     }
-    else if (type == WallType::Destructible)
+  }
+}
+
+void Maze::calculateRoundedCorners()
+{
+  for (int r = 0; r < m_rows; ++r)
+  {
+    for (int c = 0; c < m_cols; ++c)
     {
-      if (result == 0)
-      {
-        result = 1; // 记录会命中可破坏墙，但继续检查后面是否有不可破坏墙
-      }
-      // 一旦碰到可破坏墙，子弹就会停止，所以后面的墙不会被击中
-      return result;
+      updateTileCorners(r, c);
     }
-
-    // 检查是否已经到达目标附近
-    float remainDist = std::sqrt((target.x - checkPos.x) * (target.x - checkPos.x) +
-                                 (target.y - checkPos.y) * (target.y - checkPos.y));
-    if (remainDist < stepSize)
-      break;
   }
-
-  return result;
 }
 
-sf::Vector2f Maze::getFirstBlockedPosition(sf::Vector2f start, sf::Vector2f end) const
+void Maze::destroyTile(int row, int col)
 {
-  // 找到视线上第一个被阻挡的位置
-  GridPos startGrid = worldToGrid(start);
-  GridPos endGrid = worldToGrid(end);
-
-  int x0 = startGrid.x, y0 = startGrid.y;
-  int x1 = endGrid.x, y1 = endGrid.y;
+  m_tileType[tileIndex(row, col)] = WallType::None;
+  m_renderer.clearTile(row, col);
+  ++m_tileVersion;
 
-  int dx = std::abs(x1 - x0);
-  int dy = std::abs(y1 - y0);
-  int sx = x0 < x1 ? 1 : -1;
-  int sy = y0 < y1 ? 1 : -1;
-  int err = dx - dy;
+  // 邻居露出的角变为圆角
+  updateCornersAround(row, col);
+}
 
-  while (true)
+sf::Color Maze::tileFillColor(int idx) const
+{
+  switch (m_tileType[idx])
   {
-    // 检查当前格子
-    if (y0 >= 0 && y0 < m_rows && x0 >= 0 && x0 < m_cols)
-    {
-      WallType type = m_walls[y0][x0].type;
-      if (type == WallType::Solid || type == WallType::Destructible)
-      {
-        return gridToWorld({x0, y0});
-      }
-    }
+  case WallType::Solid:
+    return m_solidColor;
+  case WallType::Exit:
+    return m_exitColor;
+  case WallType::Destructible:
+    break;
+  default:
+    return sf::Color::Transparent;
+  }
 
-    if (x0 == x1 && y0 == y1)
-      break;
+  // 可破坏墙：根据血量在受损色和满血色之间插值
+  float healthRatio = m_tileHealth[idx] / WALL_MAX_HEALTH;
+  sf::Color color;
 
-    int e2 = 2 * err;
-    if (e2 > -dy)
-    {
-      err -= dy;
-      x0 += sx;
-    }
-    if (e2 < dx)
-    {
-      err += dx;
-      y0 += sy;
-    }
+  // 根据墙体属性选择对应的颜色插值
+  switch (m_tileAttribute[idx])
+  {
+  case WallAttribute::Gold:
+  {
+    // 金色墙：从深金色到亮金色
+    sf::Color dark(180, 140, 30);
+    color.r = static_cast<std::uint8_t>(dark.r + (m_goldWallColor.r - dark.r) * healthRatio);
+    color.g = static_cast<std::uint8_t>(dark.g + (m_goldWallColor.g - dark.g) * healthRatio);
+    color.b = static_cast<std::uint8_t>(dark.b + (m_goldWallColor.b - dark.b) * healthRatio);
+    break;
   }
-
-  return end; // 没有阻挡，返回目标位置
+  case WallAttribute::Heal:
+  {
+    // 蓝色墙：从深蓝色到亮蓝色
+    sf::Color dark(40, 100, 180);
+    color.r = static_cast<std::uint8_t>(dark.r + (m_healWallColor.r - dark.r) * healthRatio);
+    color.g = static_cast<std::uint8_t>(dark.g + (m_healWallColor.g - dark.g) * healthRatio);
+    color.b = static_cast<std::uint8_t>(dark.b + (m_healWallColor.b - dark.b) * healthRatio);
+    break;
+  }
+  default: // WallAttribute::None - 普通可破坏墙（棕色）
+    color.r = static_cast<std::uint8_t>(m_destructibleDamagedColor.r +
+                                        (m_destructibleColor.r - m_destructibleDamagedColor.r) * healthRatio);
+    color.g = static_cast<std::uint8_t>(m_destructibleDamagedColor.g +
+                                        (m_destructibleColor.g - m_destructibleDamagedColor.g) * healthRatio);
+    color.b = static_cast<std::uint8_t>(m_destructibleDamagedColor.b +
+                                        (m_destructibleColor.b - m_destructibleDamagedColor.b) * healthRatio);
+    break;
+  }
+  return color;
 }
 
-bool Maze::isWall(int row, int col) const
+sf::Color Maze::tileOutlineColor(int idx) const
 {
-  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols)
-    return true; // 边界外视为墙
+  if (m_tileType[idx] == WallType::Solid)
+    return sf::Color(60, 60, 60);
 
-  WallType type = m_walls[row][col].type;
-  return type == WallType::Solid || type == WallType::Destructible;
+  switch (m_tileAttribute[idx])
+  {
+  case WallAttribute::Gold:
+    return sf::Color(220, 170, 30); // 金色边框
+  case WallAttribute::Heal:
+    return sf::Color(50, 140, 220); // 蓝色边框
+  default:
+    return sf::Color(100, 60, 20);
+  }
 }
 
-void Maze::calculateRoundedCorners()
+void Maze::markDirty(int idx)
 {
-  // 对于每个墙体，检查其四个角是否需要圆角
-  // 规则：如果某个角的两个相邻方向都没有墙，则该角需要圆角
-  // 例如：左上角需要圆角的条件是：左边没有墙 AND 上边没有墙
+  if (!m_tileDirty[idx])
+  {
+    m_tileDirty[idx] = 1;
+    m_dirtyTiles.push_back(idx);
+  }
+}
 
-  for (int r = 0; r < m_rows; ++r)
+void Maze::refreshTile(int row, int col)
+{
+  const int idx = tileIndex(row, col);
+  if (m_tileType[idx] == WallType::None)
   {
-    for (int c = 0; c < m_cols; ++c)
-    {
-      Wall &wall = m_walls[r][c];
-
-      // 只处理墙体
-      if (wall.type != WallType::Solid && wall.type != WallType::Destructible && wall.type != WallType::Exit)
-        continue;
-
-      // 检查四个方向的邻居
-      bool hasTop = isWall(r - 1, c);
-      bool hasBottom = isWall(r + 1, c);
-      bool hasLeft = isWall(r, c - 1);
-      bool hasRight = isWall(r, c + 1);
-
-      // 还需要检查对角线邻居（用于更精确的判断）
-      bool hasTopLeft = isWall(r - 1, c - 1);
-      bool hasTopRight = isWall(r - 1, c + 1);
-      bool hasBottomLeft = isWall(r + 1, c - 1);
-      bool hasBottomRight = isWall(r + 1, c + 1);
-
-      // 计算每个角是否需要圆角
-      // 左上角：如果左边和上边都没有墙，则需要圆角
-      bool roundTopLeft = !hasTop && !hasLeft;
-      // 右上角：如果右边和上边都没有墙，则需要圆角
-      bool roundTopRight = !hasTop && !hasRight;
-      // 右下角：如果右边和下边都没有墙，则需要圆角
-      bool roundBottomRight = !hasBottom && !hasRight;
-      // 左下角：如果左边和下边都没有墙，则需要圆角
-      bool roundBottomLeft = !hasBottom && !hasLeft;
-
-      // 设置圆角
-      wall.roundedCorners = {roundTopLeft, roundTopRight, roundBottomRight, roundBottomLeft};
-      wall.shape.setRoundedCorners(roundTopLeft, roundTopRight, roundBottomRight, roundBottomLeft);
-    }
+    m_renderer.clearTile(row, col);
+    return;
   }
+
+  // 出口没有描边
+  float outlineThickness = m_tileType[idx] == WallType::Exit ? 0.f : 1.f;
+  m_renderer.setTile(row, col, m_tileCorners[idx], tileFillColor(idx), tileOutlineColor(idx), outlineThickness);
 }
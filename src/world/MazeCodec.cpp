@@ -0,0 +1,276 @@
+#include "MazeCodec.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+  constexpr char FILE_MAGIC[4] = {'T', 'M', 'A', 'Z'};
+
+  void writeU16(std::vector<std::uint8_t> &out, std::uint16_t value)
+  {
+    out.push_back(static_cast<std::uint8_t>(value & 0xFF));
+    out.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+  }
+
+  std::uint16_t readU16(std::span<const std::uint8_t> data, std::size_t offset)
+  {
+    return static_cast<std::uint16_t>(data[offset] | (data[offset + 1] << 8));
+  }
+
+  void writeCell(std::vector<std::uint8_t> &out, MazeCodec::Cell cell)
+  {
+    writeU16(out, cell.x);
+    writeU16(out, cell.y);
+  }
+
+  MazeCodec::Cell readCell(std::span<const std::uint8_t> data, std::size_t offset)
+  {
+    return {readU16(data, offset), readU16(data, offset + 2)};
+  }
+
+  // 半字节写入（高半字节在前）
+  class NibbleWriter
+  {
+  public:
+    explicit NibbleWriter(std::vector<std::uint8_t> &out) : m_out(out) {}
+
+    void write(std::uint8_t nibble)
+    {
+      if (m_half)
+        m_out.back() |= nibble;
+      else
+        m_out.push_back(static_cast<std::uint8_t>(nibble << 4));
+      m_half = !m_half;
+    }
+
+  private:
+    std::vector<std::uint8_t> &m_out;
+    bool m_half = false;
+  };
+}
+
+namespace MazeCodec
+{
+  Tile tileFromChar(char c)
+  {
+    switch (c)
+    {
+    case '#':
+      return Tile::Solid;
+    case '*':
+      return Tile::Destructible;
+    case 'G':
+      return Tile::Gold;
+    case 'H':
+      return Tile::Heal;
+    case 'E':
+      return Tile::Exit;
+    case 'X':
+      return Tile::Enemy;
+    default:
+      return Tile::Path;
+    }
+  }
+
+  void encode(const std::vector<std::string> &map, std::vector<std::uint8_t> &out)
+  {
+    const int rows = static_cast<int>(map.size());
+    int cols = 0;
+    for (const auto &row : map)
+    {
+      cols = std::max(cols, static_cast<int>(row.size()));
+    }
+
+    // 标记格子：同一标记出现多次时以最后一个为准（与逐字符加载一致）
+    Header header;
+    for (int r = 0; r < rows; ++r)
+    {
+      for (int c = 0; c < static_cast<int>(map[r].size()); ++c)
+      {
+        const Cell cell = {static_cast<std::uint16_t>(c), static_cast<std::uint16_t>(r)};
+        switch (map[r][c])
+        {
+        case 'S':
+          header.start = cell;
+          break;
+        case 'E':
+          header.exit = cell;
+          break;
+        case '1':
+          header.spawn1 = cell;
+          break;
+        case '2':
+          header.spawn2 = cell;
+          break;
+        default:
+          break;
+        }
+      }
+    }
+
+    out.reserve(out.size() + HEADER_SIZE + static_cast<std::size_t>(rows) * cols / 4);
+    out.push_back(VERSION);
+    writeU16(out, static_cast<std::uint16_t>(cols));
+    writeU16(out, static_cast<std::uint16_t>(rows));
+    writeCell(out, header.start);
+    writeCell(out, header.exit);
+    writeCell(out, header.spawn1);
+    writeCell(out, header.spawn2);
+
+    NibbleWriter writer(out);
+    for (const auto &row : map)
+    {
+      const int len = static_cast<int>(row.size());
+      int c = 0;
+      while (c < cols)
+      {
+        const Tile tile = c < len ? tileFromChar(row[c]) : Tile::Path;
+        int end = c + 1;
+        while (end < cols && (end < len ? tileFromChar(row[end]) : Tile::Path) == tile)
+          ++end;
+
+        // 第一个格子写字面值，其余用游程标记，剩 1 个时直接再写一次字面值
+        writer.write(static_cast<std::uint8_t>(tile));
+        int remaining = end - c - 1;
+        while (remaining >= MIN_RUN)
+        {
+          const int count = std::min(remaining, MAX_RUN);
+          writer.write(RUN);
+          writer.write(static_cast<std::uint8_t>(count - MIN_RUN));
+          remaining -= count;
+        }
+        if (remaining == 1)
+          writer.write(static_cast<std::uint8_t>(tile));
+        c = end;
+      }
+    }
+  }
+
+  bool readHeader(std::span<const std::uint8_t> data, Header &out)
+  {
+    if (data.size() < HEADER_SIZE || data[0] != VERSION)
+      return false;
+
+    out.cols = readU16(data, 1);
+    out.rows = readU16(data, 3);
+    out.start = readCell(data, 5);
+    out.exit = readCell(data, 9);
+    out.spawn1 = readCell(data, 13);
+    out.spawn2 = readCell(data, 17);
+    return out.cols > 0 && out.rows > 0;
+  }
+
+  bool validate(std::span<const std::uint8_t> data, Header &out)
+  {
+    if (!readHeader(data, out))
+      return false;
+
+    RunReader reader(data, out);
+    Run run;
+    while (reader.next(run))
+    {
+    }
+    return reader.ok();
+  }
+
+  int countTiles(std::span<const std::uint8_t> data, Tile tile)
+  {
+    Header header;
+    if (!readHeader(data, header))
+      return 0;
+
+    RunReader reader(data, header);
+    Run run;
+    int count = 0;
+    while (reader.next(run))
+    {
+      if (run.tile == tile)
+        count += run.length;
+    }
+    return reader.ok() ? count : 0;
+  }
+
+  RunReader::RunReader(std::span<const std::uint8_t> data, const Header &header)
+      : m_data(data),
+        m_nibble(HEADER_SIZE * 2),
+        m_nibbleEnd(data.size() * 2),
+        m_rows(header.rows),
+        m_cols(header.cols)
+  {
+  }
+
+  int RunReader::readNibble()
+  {
+    if (m_nibble >= m_nibbleEnd)
+      return -1;
+    const std::uint8_t byte = m_data[m_nibble >> 1];
+    const int nibble = (m_nibble & 1) ? (byte & 0x0F) : (byte >> 4);
+    ++m_nibble;
+    return nibble;
+  }
+
+  bool RunReader::next(Run &out)
+  {
+    if (m_error || m_row >= m_rows)
+      return false;
+
+    int nibble = readNibble();
+    int tile = nibble;
+    int length = 1;
+    if (nibble == RUN)
+    {
+      const int count = readNibble();
+      tile = m_prevTile;
+      length = count + MIN_RUN;
+      if (count < 0 || tile < 0)
+        nibble = -1;
+    }
+    if (nibble < 0 || tile >= static_cast<int>(Tile::Count) || m_col + length > m_cols)
+    {
+      m_error = true;
+      return false;
+    }
+
+    out.tile = static_cast<Tile>(tile);
+    out.row = m_row;
+    out.col = m_col;
+    out.length = length;
+
+    m_col += length;
+    m_prevTile = tile;
+    if (m_col == m_cols)
+    {
+      ++m_row;
+      m_col = 0;
+      m_prevTile = -1;
+    }
+    return true;
+  }
+
+  bool saveToFile(const std::string &path, std::span<const std::uint8_t> packed)
+  {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+      return false;
+
+    file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    file.write(reinterpret_cast<const char *>(packed.data()), static_cast<std::streamsize>(packed.size()));
+    return static_cast<bool>(file);
+  }
+
+  bool loadFromFile(const std::string &path, std::vector<std::uint8_t> &outPacked)
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      return false;
+
+    char magic[sizeof(FILE_MAGIC)] = {};
+    if (!file.read(magic, sizeof(magic)) || !std::equal(std::begin(magic), std::end(magic), FILE_MAGIC))
+      return false;
+
+    outPacked.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    Header header;
+    return validate(outPacked, header);
+  }
+}
@@ -2,6 +2,38 @@
 #include <algorithm>
 #include <ctime>
 #include <set>
+#include <tuple>
+
+namespace
+{
+  // 四个方向：上、右、下、左
+  constexpr int DX4[] = {0, 1, 0, -1};
+  constexpr int DY4[] = {-1, 0, 1, 0};
+
+  // 按距离从远到近稳定排序（计数排序，距离是小整数，O(n + 最大距离)）
+  template <typename T, typename Key>
+  void sortByDistanceDesc(std::vector<T> &items, Key key)
+  {
+    if (items.size() < 2)
+      return;
+
+    int maxDist = 0;
+    for (const auto &item : items)
+      maxDist = std::max(maxDist, key(item));
+
+    // 每个距离的起始位置（远的在前）
+    std::vector<std::size_t> offsets(static_cast<std::size_t>(maxDist) + 2, 0);
+    for (const auto &item : items)
+      ++offsets[maxDist - key(item) + 1];
+    for (std::size_t i = 1; i < offsets.size(); ++i)
+      offsets[i] += offsets[i - 1];
+
+    std::vector<T> sorted(items.size());
+    for (auto &item : items)
+      sorted[offsets[maxDist - key(item)]++] = std::move(item);
+    items.swap(sorted);
+  }
+}
 
 MazeGenerator::MazeGenerator(int width, int height)
     : m_width(width), m_height(height), m_seed(0), m_seedSet(false)
@@ -22,22 +54,19 @@ void MazeGenerator::setSeed(unsigned int seed)
 std::vector<std::string> MazeGenerator::generate()
 {
   // 在生成开始时设置随机数种子，确保相同种子产生相同结果
-  if (m_seedSet)
-  {
-    m_rng.seed(m_seed);
-  }
-  else
+  if (!m_seedSet)
   {
-    m_rng.seed(static_cast<unsigned int>(std::time(nullptr)));
+    m_seed = static_cast<unsigned int>(std::time(nullptr));
   }
+  m_rng.seed(m_seed);
 
   // 初始化网格，全部填充墙
-  m_grid.clear();
-  m_grid.resize(m_height, std::vector<char>(m_width, '#'));
+  m_grid.assign(static_cast<std::size_t>(m_width) * m_height, '#');
 
-  // 使用递归回溯法生成迷宫
+  // 使用回溯法生成迷宫
   // 从 (1,1) 开始挖通道
   carvePassage(1, 1);
+  m_componentsValid = false;
 
   // 根据模式放置起点/出生点和终点
   if (m_multiplayerMode)
@@ -67,38 +96,91 @@ std::vector<std::string> MazeGenerator::generate()
   result.reserve(m_height);
   for (int y = 0; y < m_height; ++y)
   {
-    result.push_back(std::string(m_grid[y].begin(), m_grid[y].end()));
+    const auto row = m_grid.begin() + static_cast<std::ptrdiff_t>(y) * m_width;
+    result.emplace_back(row, row + m_width);
   }
 
   return result;
 }
 
-void MazeGenerator::carvePassage(int cx, int cy)
+std::vector<std::string> MazeGenerator::generateFromRecipe(const MazeRecipe &recipe)
 {
-  // 四个方向：上、右、下、左
-  int dx[] = {0, 2, 0, -2};
-  int dy[] = {-2, 0, 2, 0};
+  MazeGenerator generator(recipe.width, recipe.height);
+  generator.setSeed(recipe.seed);
+  generator.setEnemyCount(recipe.enemyCount);
+  generator.setMultiplayerMode(recipe.multiplayerMode);
+  generator.setEscapeMode(recipe.escapeMode);
+  return generator.generate();
+}
+
+bool MazeGenerator::isValidRecipe(const MazeRecipe &recipe)
+{
+  return recipe.width >= MIN_MAZE_SIZE && recipe.width <= MAX_MAZE_SIZE &&
+         recipe.height >= MIN_MAZE_SIZE && recipe.height <= MAX_MAZE_SIZE &&
+         recipe.enemyCount >= 0 && recipe.enemyCount <= MAX_ENEMY_COUNT;
+}
+
+std::uint32_t MazeGenerator::checksum(const std::vector<std::string> &mazeData)
+{
+  std::uint32_t hash = 2166136261u;
+  auto mix = [&hash](std::uint8_t byte)
+  {
+    hash ^= byte;
+    hash *= 16777619u;
+  };
 
-  // 随机打乱方向
-  std::vector<int> dirs = {0, 1, 2, 3};
-  std::shuffle(dirs.begin(), dirs.end(), m_rng);
+  for (const auto &row : mazeData)
+  {
+    for (char c : row)
+      mix(static_cast<std::uint8_t>(c));
+    mix('\n'); // 行分隔，避免不同尺寸得到相同的序列
+  }
+  return hash;
+}
 
-  m_grid[cy][cx] = '.';
+void MazeGenerator::carvePassage(int startX, int startY)
+{
+  // 四个方向：上、右、下、左
+  constexpr int dx[] = {0, 2, 0, -2};
+  constexpr int dy[] = {-2, 0, 2, 0};
+
+  // 显式栈代替递归（深度与格子数成正比，大迷宫会耗尽线程栈）
+  // 进入格子时打乱方向、逐个尝试，与递归版本的随机数调用顺序完全一致
+  m_carveStack.clear();
+  m_carveStack.reserve(static_cast<std::size_t>(m_width / 2) * (m_height / 2));
+
+  auto enter = [this](int x, int y)
+  {
+    CarveFrame frame;
+    frame.x = x;
+    frame.y = y;
+    m_rng.shuffle(frame.dirs);
+    cell(x, y) = '.';
+    m_carveStack.push_back(frame);
+  };
 
-  for (int dir : dirs)
+  enter(startX, startY);
+  while (!m_carveStack.empty())
   {
-    int nx = cx + dx[dir];
-    int ny = cy + dy[dir];
+    CarveFrame &frame = m_carveStack.back();
+    if (frame.next == 4)
+    {
+      m_carveStack.pop_back();
+      continue;
+    }
+
+    const int dir = frame.dirs[frame.next++];
+    const int cx = frame.x;
+    const int cy = frame.y;
+    const int nx = cx + dx[dir];
+    const int ny = cy + dy[dir];
 
     // 检查边界
-    if (nx > 0 && nx < m_width - 1 && ny > 0 && ny < m_height - 1)
+    if (nx > 0 && nx < m_width - 1 && ny > 0 && ny < m_height - 1 && cell(nx, ny) == '#')
     {
-      if (m_grid[ny][nx] == '#')
-      {
-        // 打通中间的墙
-        m_grid[cy + dy[dir] / 2][cx + dx[dir] / 2] = '.';
-        carvePassage(nx, ny);
-      }
+      // 打通中间的墙（enter 可能使 frame 失效，先用完它）
+      cell(cx + dx[dir] / 2, cy + dy[dir] / 2) = '.';
+      enter(nx, ny);
     }
   }
 }
@@ -110,7 +192,7 @@ std::vector<std::pair<int, int>> MazeGenerator::getEmptySpaces()
   {
     for (int x = 1; x < m_width - 1; ++x)
     {
-      if (m_grid[y][x] == '.')
+      if (cell(x, y) == '.')
       {
         spaces.push_back({x, y});
       }
@@ -129,80 +211,144 @@ void MazeGenerator::placeStartAndEnd()
     m_startY = 1;
     m_endX = m_width - 2;
     m_endY = m_height - 2;
-    m_grid[m_startY][m_startX] = 'S';
-    m_grid[m_endY][m_endX] = 'E';
+    cell(m_startX, m_startY) = 'S';
+    cell(m_endX, m_endY) = 'E';
     return;
   }
 
-  std::shuffle(emptySpaces.begin(), emptySpaces.end(), m_rng);
+  m_rng.shuffle(emptySpaces);
 
   // 随机选一个起点
   auto [sx, sy] = emptySpaces[0];
 
-  // 计算所有点与起点的距离，并排序
+  // 计算所有点与起点的路径距离（一次 BFS），并排序
+  computeDistances(sx, sy, m_distanceA);
   std::vector<std::pair<int, std::pair<int, int>>> distancePoints;
+  distancePoints.reserve(emptySpaces.size());
   for (size_t i = 1; i < emptySpaces.size(); ++i)
   {
     auto [ex, ey] = emptySpaces[i];
-    int dist = std::abs(ex - sx) + std::abs(ey - sy);
+    int dist = std::max(0, m_distanceA[index(ex, ey)]); // 不可达的排在最后
     distancePoints.push_back({dist, {ex, ey}});
   }
 
   // 按距离排序（从远到近）
-  std::sort(distancePoints.begin(), distancePoints.end(),
-            [](const auto &a, const auto &b)
-            { return a.first > b.first; });
+  sortByDistanceDesc(distancePoints, [](const auto &p)
+                     { return p.first; });
 
   // 从距离最远的前 40% 中随机选一个作为终点
   // 确保起点离终点足够远
   int topCount = std::max(1, static_cast<int>(distancePoints.size() * 0.4));
-  int selectedIdx = m_rng() % topCount;
+  int selectedIdx = static_cast<int>(m_rng.below(static_cast<std::uint32_t>(topCount)));
 
   m_startX = sx;
   m_startY = sy;
   m_endX = distancePoints[selectedIdx].second.first;
   m_endY = distancePoints[selectedIdx].second.second;
 
-  m_grid[m_startY][m_startX] = 'S';
-  m_grid[m_endY][m_endX] = 'E';
+  cell(m_startX, m_startY) = 'S';
+  cell(m_endX, m_endY) = 'E';
 }
 
-void MazeGenerator::ensurePath(int startX, int startY, int endX, int endY)
+void MazeGenerator::computeDistances(int startX, int startY, std::vector<int> &outDistance, int maxDistance)
 {
-  // 使用 BFS 确保起点到终点有路径
-  // 如果没有路径，打通一些墙
+  const std::size_t cellCount = m_grid.size();
+  outDistance.assign(cellCount, -1);
+  m_bfsQueue.resize(cellCount);
 
-  std::vector<std::vector<bool>> visited(m_height, std::vector<bool>(m_width, false));
-  std::vector<std::pair<int, int>> queue;
-  queue.push_back({startX, startY});
-  visited[startY][startX] = true;
+  // 起点本身不要求可通行（回退出生点可能落在墙上）
+  int head = 0;
+  int tail = 0;
+  outDistance[index(startX, startY)] = 0;
+  m_bfsQueue[tail++] = index(startX, startY);
 
-  int dx[] = {0, 1, 0, -1};
-  int dy[] = {-1, 0, 1, 0};
-
-  while (!queue.empty())
+  while (head < tail)
   {
-    auto [x, y] = queue.front();
-    queue.erase(queue.begin());
+    const int current = m_bfsQueue[head++];
+    const int x = current % m_width;
+    const int y = current / m_width;
+    const int nextDist = outDistance[current] + 1;
+    if (maxDistance >= 0 && nextDist > maxDistance)
+      break; // BFS 按距离递增出队，之后的格子都更远
 
-    if (x == endX && y == endY)
+    for (int i = 0; i < 4; ++i)
     {
-      return; // 找到路径
+      const int nx = x + DX4[i];
+      const int ny = y + DY4[i];
+      if (!isOpen(nx, ny))
+        continue;
+
+      const int next = index(nx, ny);
+      if (outDistance[next] < 0)
+      {
+        outDistance[next] = nextDist;
+        m_bfsQueue[tail++] = next;
+      }
     }
+  }
+}
 
-    for (int i = 0; i < 4; ++i)
+void MazeGenerator::labelComponents()
+{
+  const std::size_t cellCount = m_grid.size();
+  m_component.assign(cellCount, -1);
+  m_bfsQueue.resize(cellCount);
+
+  // 每个未标记的可通行格子开始一次泛洪，整张图只访问一遍
+  int label = 0;
+  for (int y = 1; y < m_height - 1; ++y)
+  {
+    for (int x = 1; x < m_width - 1; ++x)
     {
-      int nx = x + dx[i];
-      int ny = y + dy[i];
+      if (!isOpen(x, y) || m_component[index(x, y)] >= 0)
+        continue;
+
+      int head = 0;
+      int tail = 0;
+      m_component[index(x, y)] = label;
+      m_bfsQueue[tail++] = index(x, y);
 
-      if (nx > 0 && nx < m_width - 1 && ny > 0 && ny < m_height - 1 && !visited[ny][nx])
+      while (head < tail)
       {
-        if (m_grid[ny][nx] != '#')
+        const int current = m_bfsQueue[head++];
+        const int cx = current % m_width;
+        const int cy = current / m_width;
+        for (int i = 0; i < 4; ++i)
         {
-          visited[ny][nx] = true;
-          queue.push_back({nx, ny});
+          const int nx = cx + DX4[i];
+          const int ny = cy + DY4[i];
+          if (isOpen(nx, ny) && m_component[index(nx, ny)] < 0)
+          {
+            m_component[index(nx, ny)] = label;
+            m_bfsQueue[tail++] = index(nx, ny);
+          }
         }
       }
+      ++label;
+    }
+  }
+  m_componentsValid = true;
+}
+
+void MazeGenerator::ensurePath(int startX, int startY, int endX, int endY)
+{
+  // 用连通分量判断起点到终点是否有路径
+  // 如果没有路径，打通一些墙
+  if (!m_componentsValid)
+    labelComponents();
+
+  // 起点在墙上时看它的可通行邻居（与从起点出发做 BFS 等价）
+  const int endComponent = m_component[index(endX, endY)];
+  if (endComponent >= 0)
+  {
+    if (m_component[index(startX, startY)] == endComponent)
+      return;
+    for (int i = 0; i < 4; ++i)
+    {
+      const int nx = startX + DX4[i];
+      const int ny = startY + DY4[i];
+      if (isOpen(nx, ny) && m_component[index(nx, ny)] == endComponent)
+        return;
     }
   }
 
@@ -211,7 +357,7 @@ void MazeGenerator::ensurePath(int startX, int startY, int endX, int endY)
   while (x != endX || y != endY)
   {
     // 随机决定先走X还是Y
-    bool moveX = (m_rng() % 2 == 0);
+    bool moveX = (m_rng.below(2) == 0);
 
     if (moveX && x != endX)
     {
@@ -226,29 +372,35 @@ void MazeGenerator::ensurePath(int startX, int startY, int endX, int endY)
       x += (endX > x) ? 1 : -1;
     }
 
-    if (m_grid[y][x] == '#')
-      m_grid[y][x] = '.';
+    if (cell(x, y) == '#')
+      cell(x, y) = '.';
   }
+
+  // 挖了墙，连通分量需要重新标记
+  m_componentsValid = false;
 }
 
 void MazeGenerator::placeEnemies()
 {
   std::vector<std::pair<int, int>> emptySpaces;
 
+  // 到起点和终点的路径距离（各一次 BFS），不可达的格子视为足够远
+  computeDistances(m_startX, m_startY, m_distanceA);
+  computeDistances(m_endX, m_endY, m_distanceB);
+
   // 收集所有空地（排除起点和终点附近）
   int minDistFromStart = 5; // 距离起点至少5格
   for (int y = 1; y < m_height - 1; ++y)
   {
     for (int x = 1; x < m_width - 1; ++x)
     {
-      if (m_grid[y][x] == '.')
+      if (cell(x, y) == '.')
       {
-        // 计算与起点的距离
-        int distFromStart = std::abs(x - m_startX) + std::abs(y - m_startY);
-        int distFromEnd = std::abs(x - m_endX) + std::abs(y - m_endY);
+        int distFromStart = m_distanceA[index(x, y)];
+        int distFromEnd = m_distanceB[index(x, y)];
 
         // 不要太靠近起点或终点
-        if (distFromStart > minDistFromStart && distFromEnd > 3)
+        if ((distFromStart < 0 || distFromStart > minDistFromStart) && (distFromEnd < 0 || distFromEnd > 3))
         {
           emptySpaces.push_back({x, y});
         }
@@ -257,13 +409,13 @@ void MazeGenerator::placeEnemies()
   }
 
   // 随机放置敌人
-  std::shuffle(emptySpaces.begin(), emptySpaces.end(), m_rng);
+  m_rng.shuffle(emptySpaces);
   int enemiesPlaced = 0;
   for (const auto &pos : emptySpaces)
   {
     if (enemiesPlaced >= m_enemyCount)
       break;
-    m_grid[pos.second][pos.first] = 'X';
+    cell(pos.first, pos.second) = 'X';
     enemiesPlaced++;
   }
 }
@@ -277,7 +429,7 @@ void MazeGenerator::placeDestructibleWalls()
   {
     for (int x = 1; x < m_width - 1; ++x)
     {
-      if (m_grid[y][x] == '#')
+      if (cell(x, y) == '#')
       {
         // 检查是否有相邻的通道
         bool hasAdjacentPath = false;
@@ -290,7 +442,7 @@ void MazeGenerator::placeDestructibleWalls()
           int ny = y + dy[i];
           if (nx >= 0 && nx < m_width && ny >= 0 && ny < m_height)
           {
-            if (m_grid[ny][nx] == '.' || m_grid[ny][nx] == 'S' || m_grid[ny][nx] == 'E')
+            if (cell(nx, ny) == '.' || cell(nx, ny) == 'S' || cell(nx, ny) == 'E')
             {
               hasAdjacentPath = true;
               break;
@@ -301,7 +453,7 @@ void MazeGenerator::placeDestructibleWalls()
         // 只有相邻有通道的墙才可能变成可破坏墙
         if (hasAdjacentPath)
         {
-          float roll = static_cast<float>(m_rng() % 1000) / 1000.f;
+          float roll = static_cast<float>(m_rng.below(1000)) / 1000.f;
           if (roll < m_destructibleRatio)
           {
             destructibleCandidates.push_back({x, y});
@@ -319,14 +471,14 @@ void MazeGenerator::placeDestructibleWalls()
       // 单人 Escape 模式：30%治疗，70%普通
       for (const auto &[x, y] : destructibleCandidates)
       {
-        float roll = static_cast<float>(m_rng() % 1000) / 1000.f;
+        float roll = static_cast<float>(m_rng.below(1000)) / 1000.f;
         if (roll < 0.30f)
         {
-          m_grid[y][x] = 'H'; // Heal (蓝色)
+          cell(x, y) = 'H'; // Heal (蓝色)
         }
         else
         {
-          m_grid[y][x] = '*'; // 普通 (棕色)
+          cell(x, y) = '*'; // 普通 (棕色)
         }
       }
     }
@@ -335,7 +487,7 @@ void MazeGenerator::placeDestructibleWalls()
       // 单人 Battle 模式：所有都是普通墙
       for (const auto &[x, y] : destructibleCandidates)
       {
-        m_grid[y][x] = '*'; // 普通可破坏墙
+        cell(x, y) = '*'; // 普通可破坏墙
       }
     }
     return;
@@ -348,14 +500,14 @@ void MazeGenerator::placeDestructibleWalls()
     // 30%治疗，70%普通
     for (const auto &[x, y] : destructibleCandidates)
     {
-      float roll = static_cast<float>(m_rng() % 1000) / 1000.f;
+      float roll = static_cast<float>(m_rng.below(1000)) / 1000.f;
       if (roll < 0.30f)
       {
-        m_grid[y][x] = 'H'; // Heal (蓝色)
+        cell(x, y) = 'H'; // Heal (蓝色)
       }
       else
       {
-        m_grid[y][x] = '*'; // 普通 (棕色)
+        cell(x, y) = '*'; // 普通 (棕色)
       }
     }
   }
@@ -364,18 +516,18 @@ void MazeGenerator::placeDestructibleWalls()
     // Battle 模式：15%金色，10%治疗，75%普通
     for (const auto &[x, y] : destructibleCandidates)
     {
-      float roll = static_cast<float>(m_rng() % 1000) / 1000.f;
+      float roll = static_cast<float>(m_rng.below(1000)) / 1000.f;
       if (roll < 0.15f)
       {
-        m_grid[y][x] = 'G'; // Gold
+        cell(x, y) = 'G'; // Gold
       }
       else if (roll < 0.25f)
       {
-        m_grid[y][x] = 'H'; // Heal
+        cell(x, y) = 'H'; // Heal
       }
       else
       {
-        m_grid[y][x] = '*'; // 普通
+        cell(x, y) = '*'; // 普通
       }
     }
   }
@@ -398,9 +550,9 @@ void MazeGenerator::placeMultiplayerSpawns()
     m_spawn2Y = m_height / 2;
     m_endX = m_width - 2;
     m_endY = m_height - 2;
-    m_grid[m_spawn1Y][m_spawn1X] = '1';
-    m_grid[m_spawn2Y][m_spawn2X] = '2';
-    m_grid[m_endY][m_endX] = 'E';
+    cell(m_spawn1X, m_spawn1Y) = '1';
+    cell(m_spawn2X, m_spawn2Y) = '2';
+    cell(m_endX, m_endY) = 'E';
     return;
   }
 
@@ -423,7 +575,7 @@ void MazeGenerator::placeMultiplayerSpawns()
   std::vector<std::pair<int, int>> spawnCandidates;
   for (const auto &[x, y] : emptySpaces)
   {
-    if (m_grid[y][x] == '.' || m_grid[y][x] == 'S')
+    if (cell(x, y) == '.' || cell(x, y) == 'S')
     {
       // 在中部区域
       if (x >= centerMinX && x < centerMaxX && y >= centerMinY && y < centerMaxY)
@@ -441,7 +593,7 @@ void MazeGenerator::placeMultiplayerSpawns()
     int smallMarginY = m_height / 6;
     for (const auto &[x, y] : emptySpaces)
     {
-      if (m_grid[y][x] == '.' || m_grid[y][x] == 'S')
+      if (cell(x, y) == '.' || cell(x, y) == 'S')
       {
         if (x >= smallMarginX && x < m_width - smallMarginX &&
             y >= smallMarginY && y < m_height - smallMarginY)
@@ -458,37 +610,42 @@ void MazeGenerator::placeMultiplayerSpawns()
   }
 
   // 随机打乱候选点
-  std::shuffle(spawnCandidates.begin(), spawnCandidates.end(), m_rng);
+  m_rng.shuffle(spawnCandidates);
 
   // 找两个有一定距离的出生点
   int minSpawnDist = std::max(6, std::min(m_width, m_height) / 4);  // 最小距离（增大）
   int maxSpawnDist = std::max(15, std::min(m_width, m_height) / 2); // 最大距离
 
-  // 收集符合条件的出生点对
-  std::vector<std::pair<int, int>> validSpawnPairs; // 存储索引对
-  for (size_t i = 0; i < spawnCandidates.size() && i < 30; ++i)
+  // 按路径距离找出生点对：依次以候选点为出生点1做 BFS（只搜到最大距离），
+  // 第一个有合适出生点2 的候选即为出生点1，从它的合适搭档中随机选一个
+  // 候选已打乱，通常第一次 BFS 就能找到
+  std::vector<int> validPartners; // 出生点2 在候选中的下标
+  int spawn1Idx = -1;
+  for (size_t i = 0; i < spawnCandidates.size() && i < 30 && spawn1Idx < 0; ++i)
   {
-    for (size_t j = i + 1; j < spawnCandidates.size() && j < 30; ++j)
+    auto [x1, y1] = spawnCandidates[i];
+    computeDistances(x1, y1, m_distanceA, maxSpawnDist);
+    for (size_t j = 0; j < spawnCandidates.size() && j < 30; ++j)
     {
-      auto [x1, y1] = spawnCandidates[i];
       auto [x2, y2] = spawnCandidates[j];
-      int dist = std::abs(x1 - x2) + std::abs(y1 - y2);
-      if (dist >= minSpawnDist && dist <= maxSpawnDist)
+      int dist = m_distanceA[index(x2, y2)];
+      if (j != i && dist >= minSpawnDist && dist <= maxSpawnDist)
       {
-        validSpawnPairs.push_back({static_cast<int>(i), static_cast<int>(j)});
+        validPartners.push_back(static_cast<int>(j));
       }
     }
+    if (!validPartners.empty())
+      spawn1Idx = static_cast<int>(i);
   }
 
-  // 从有效的出生点对中随机选择一对
-  if (!validSpawnPairs.empty())
+  // 从合适的搭档中随机选择出生点2
+  if (spawn1Idx >= 0)
   {
-    int pairIdx = m_rng() % validSpawnPairs.size();
-    auto [idx1, idx2] = validSpawnPairs[pairIdx];
-    m_spawn1X = spawnCandidates[idx1].first;
-    m_spawn1Y = spawnCandidates[idx1].second;
-    m_spawn2X = spawnCandidates[idx2].first;
-    m_spawn2Y = spawnCandidates[idx2].second;
+    int partnerIdx = validPartners[m_rng.below(static_cast<std::uint32_t>(validPartners.size()))];
+    m_spawn1X = spawnCandidates[spawn1Idx].first;
+    m_spawn1Y = spawnCandidates[spawn1Idx].second;
+    m_spawn2X = spawnCandidates[partnerIdx].first;
+    m_spawn2Y = spawnCandidates[partnerIdx].second;
   }
   else if (spawnCandidates.size() >= 2)
   {
@@ -507,18 +664,22 @@ void MazeGenerator::placeMultiplayerSpawns()
     m_spawn2Y = m_height / 2;
   }
 
-  // 筛选边缘区域的空地作为终点候选，并计算到两个出生点的距离
+  // 筛选边缘区域的空地作为终点候选，并计算到两个出生点的路径距离（各一次 BFS）
+  computeDistances(m_spawn1X, m_spawn1Y, m_distanceA);
+  computeDistances(m_spawn2X, m_spawn2Y, m_distanceB);
   std::vector<std::tuple<int, int, int, int>> endCandidates; // {x, y, minDist, distDiff}
 
   for (const auto &[x, y] : emptySpaces)
   {
-    if (m_grid[y][x] == '.' || m_grid[y][x] == 'S')
+    if (cell(x, y) == '.' || cell(x, y) == 'S')
     {
       // 优先选择边缘区域的点
       if (isEdgeArea(x, y))
       {
-        int distToSpawn1 = std::abs(x - m_spawn1X) + std::abs(y - m_spawn1Y);
-        int distToSpawn2 = std::abs(x - m_spawn2X) + std::abs(y - m_spawn2Y);
+        int distToSpawn1 = m_distanceA[index(x, y)];
+        int distToSpawn2 = m_distanceB[index(x, y)];
+        if (distToSpawn1 < 0 || distToSpawn2 < 0)
+          continue;
         int minDist = std::min(distToSpawn1, distToSpawn2);
         int distDiff = std::abs(distToSpawn1 - distToSpawn2);
 
@@ -536,12 +697,14 @@ void MazeGenerator::placeMultiplayerSpawns()
   {
     for (const auto &[x, y] : emptySpaces)
     {
-      if (m_grid[y][x] == '.' || m_grid[y][x] == 'S')
+      if (cell(x, y) == '.' || cell(x, y) == 'S')
       {
         if (!isEdgeArea(x, y))
         {
-          int distToSpawn1 = std::abs(x - m_spawn1X) + std::abs(y - m_spawn1Y);
-          int distToSpawn2 = std::abs(x - m_spawn2X) + std::abs(y - m_spawn2Y);
+          int distToSpawn1 = m_distanceA[index(x, y)];
+          int distToSpawn2 = m_distanceB[index(x, y)];
+          if (distToSpawn1 < 0 || distToSpawn2 < 0)
+            continue;
           int minDist = std::min(distToSpawn1, distToSpawn2);
           int distDiff = std::abs(distToSpawn1 - distToSpawn2);
 
@@ -556,15 +719,14 @@ void MazeGenerator::placeMultiplayerSpawns()
   }
 
   // 按距离排序（从远到近），优先选择距离远的
-  std::sort(endCandidates.begin(), endCandidates.end(),
-            [](const auto &a, const auto &b)
-            { return std::get<2>(a) > std::get<2>(b); });
+  sortByDistanceDesc(endCandidates, [](const auto &c)
+                     { return std::get<2>(c); });
 
   // 从距离最远的前 30% 中随机选一个作为终点
   if (!endCandidates.empty())
   {
     int topCount = std::max(1, static_cast<int>(endCandidates.size() * 0.3));
-    int selectedIdx = m_rng() % topCount;
+    int selectedIdx = static_cast<int>(m_rng.below(static_cast<std::uint32_t>(topCount)));
     m_endX = std::get<0>(endCandidates[selectedIdx]);
     m_endY = std::get<1>(endCandidates[selectedIdx]);
   }
@@ -574,22 +736,22 @@ void MazeGenerator::placeMultiplayerSpawns()
     m_endX = m_width - 2;
     m_endY = m_height - 2;
   }
-  m_grid[m_endY][m_endX] = 'E';
+  cell(m_endX, m_endY) = 'E';
 
   // 在地图上标记出生点，用 '1' 和 '2' 表示
   // 确保位置是空地才标记
   if (m_spawn1Y >= 0 && m_spawn1Y < m_height && m_spawn1X >= 0 && m_spawn1X < m_width)
   {
-    if (m_grid[m_spawn1Y][m_spawn1X] == '.' || m_grid[m_spawn1Y][m_spawn1X] == 'S')
+    if (cell(m_spawn1X, m_spawn1Y) == '.' || cell(m_spawn1X, m_spawn1Y) == 'S')
     {
-      m_grid[m_spawn1Y][m_spawn1X] = '1';
+      cell(m_spawn1X, m_spawn1Y) = '1';
     }
   }
   if (m_spawn2Y >= 0 && m_spawn2Y < m_height && m_spawn2X >= 0 && m_spawn2X < m_width)
   {
-    if (m_grid[m_spawn2Y][m_spawn2X] == '.' || m_grid[m_spawn2Y][m_spawn2X] == 'S')
+    if (cell(m_spawn2X, m_spawn2Y) == '.' || cell(m_spawn2X, m_spawn2Y) == 'S')
     {
-      m_grid[m_spawn2Y][m_spawn2X] = '2';
+      cell(m_spawn2X, m_spawn2Y) = '2';
     }
   }
 }
@@ -0,0 +1,111 @@
+#include "MazePool.hpp"
+#include <random>
+#include <string>
+
+MazePool::MazePool(std::size_t workerCount, std::size_t readyTarget)
+    : m_readyTarget(readyTarget)
+{
+  m_workers.reserve(workerCount);
+  for (std::size_t i = 0; i < workerCount; ++i)
+  {
+    m_workers.emplace_back(&MazePool::workerLoop, this);
+  }
+}
+
+MazePool::~MazePool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  for (auto &worker : m_workers)
+  {
+    if (worker.joinable())
+      worker.join();
+  }
+}
+
+bool MazePool::sameSettings(const MazeRecipe &a, const MazeRecipe &b)
+{
+  return a.width == b.width && a.height == b.height && a.enemyCount == b.enemyCount &&
+         a.multiplayerMode == b.multiplayerMode && a.escapeMode == b.escapeMode;
+}
+
+void MazePool::configure(const MazeRecipe &settings)
+{
+  // 旧设置的迷宫全部作废（在锁外释放，大迷宫的内存释放也不算便宜）
+  std::deque<std::unique_ptr<PreparedMaze>> stale;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_configured && sameSettings(m_settings, settings))
+      return;
+
+    m_settings = settings;
+    m_configured = true;
+    ++m_generation;
+    m_ready.swap(stale);
+  }
+  m_wake.notify_all();
+}
+
+std::unique_ptr<PreparedMaze> MazePool::tryTake(const MazeRecipe &settings)
+{
+  configure(settings);
+
+  std::unique_ptr<PreparedMaze> prepared;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_ready.empty())
+      return nullptr;
+    prepared = std::move(m_ready.front());
+    m_ready.pop_front();
+  }
+  m_wake.notify_one(); // 补上取走的那个
+  return prepared;
+}
+
+void MazePool::workerLoop()
+{
+  std::random_device device;
+
+  while (true)
+  {
+    MazeRecipe recipe;
+    std::uint32_t generation = 0;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [this]
+                  { return m_stopping || (m_configured && m_ready.size() + m_inFlight < m_readyTarget); });
+      if (m_stopping)
+        return;
+
+      recipe = m_settings;
+      generation = m_generation;
+      ++m_inFlight;
+    }
+
+    // 生成并解析（包括墙体几何烘焙）都在工作线程完成
+    recipe.seed = device();
+    if (recipe.seed == 0)
+      recipe.seed = 1; // 0 表示不指定种子
+
+    auto prepared = std::make_unique<PreparedMaze>();
+    const std::vector<std::string> mazeData = MazeGenerator::generateFromRecipe(recipe);
+    prepared->recipe = recipe;
+    prepared->checksum = MazeGenerator::checksum(mazeData);
+    prepared->maze.loadFromString(mazeData);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      --m_inFlight;
+      if (generation == m_generation && !m_stopping)
+      {
+        m_ready.push_back(std::move(prepared));
+        continue;
+      }
+    }
+    // 设置已经改变，结果作废（在锁外释放）
+    prepared.reset();
+  }
+}
@@ -0,0 +1,271 @@
+#include "MazeRenderer.hpp"
+#include "RoundedRectangle.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  // 边 p1->p2 的单位法线
+  sf::Vector2f edgeNormal(sf::Vector2f p1, sf::Vector2f p2)
+  {
+    sf::Vector2f normal(p1.y - p2.y, p2.x - p1.x);
+    float length = std::sqrt(normal.x * normal.x + normal.y * normal.y);
+    if (length > 0.f)
+      normal /= length;
+    return normal;
+  }
+}
+
+MazeRenderer::MazeRenderer()
+{
+}
+
+void MazeRenderer::reset(int rows, int cols, float tileSize, float cornerRadius)
+{
+  m_rows = rows;
+  m_cols = cols;
+  m_tileSize = tileSize;
+  m_chunkRows = (rows + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  m_chunkCols = (cols + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  m_chunks.clear();
+  m_chunks.resize(static_cast<std::size_t>(m_chunkRows) * m_chunkCols);
+  m_tileSlot.assign(static_cast<std::size_t>(rows) * cols, -1);
+  m_tileCapacity.assign(static_cast<std::size_t>(rows) * cols, 0);
+  m_tileMask.assign(static_cast<std::size_t>(rows) * cols, 0);
+  buildTemplates(tileSize, cornerRadius);
+}
+
+void MazeRenderer::buildTemplates(float tileSize, float cornerRadius)
+{
+  // 用 SelectiveRoundedRectShape 生成 16 种圆角组合的轮廓点，之后每个格子只做平移
+  SelectiveRoundedRectShape shape({tileSize - 2.f, tileSize - 2.f}, cornerRadius, CORNER_POINTS);
+  const sf::Vector2f offset(1.f, 1.f); // 与原来形状的 1 像素内缩一致
+  const sf::Vector2f center(tileSize / 2.f, tileSize / 2.f);
+
+  for (int mask = 0; mask < 16; ++mask)
+  {
+    shape.setRoundedCorners((mask & 1) != 0, (mask & 2) != 0, (mask & 4) != 0, (mask & 8) != 0);
+
+    const std::size_t count = shape.getPointCount();
+    std::array<sf::Vector2f, MAX_POINTS> points;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      points[i] = shape.getPoint(i) + offset;
+    }
+
+    TileTemplate &tpl = m_templates[mask];
+
+    // 填充：凸多边形以第 0 个点做扇形三角化
+    std::size_t v = 0;
+    for (std::size_t i = 1; i + 1 < count; ++i)
+    {
+      tpl.fill[v++] = points[0];
+      tpl.fill[v++] = points[i];
+      tpl.fill[v++] = points[i + 1];
+    }
+    tpl.fillCount = v;
+
+    // 描边：与 sf::Shape 相同的斜接法线，沿法线外扩描边厚度
+    std::array<sf::Vector2f, MAX_POINTS> normals;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      sf::Vector2f prev = points[(i + count - 1) % count];
+      sf::Vector2f curr = points[i];
+      sf::Vector2f next = points[(i + 1) % count];
+
+      sf::Vector2f n1 = edgeNormal(prev, curr);
+      sf::Vector2f n2 = edgeNormal(curr, next);
+
+      // 确保法线朝外
+      sf::Vector2f toCenter = center - curr;
+      if (n1.x * toCenter.x + n1.y * toCenter.y > 0.f)
+        n1 = -n1;
+      if (n2.x * toCenter.x + n2.y * toCenter.y > 0.f)
+        n2 = -n2;
+
+      float factor = 1.f + (n1.x * n2.x + n1.y * n2.y);
+      normals[i] = (n1 + n2) / factor;
+    }
+
+    v = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      std::size_t j = (i + 1) % count;
+      const sf::Vector2f base[6] = {points[i], points[i], points[j], points[j], points[i], points[j]};
+      const sf::Vector2f dir[6] = {{0.f, 0.f}, normals[i], {0.f, 0.f}, {0.f, 0.f}, normals[i], normals[j]};
+      for (int k = 0; k < 6; ++k)
+      {
+        tpl.outlineBase[v] = base[k];
+        tpl.outlineNormal[v] = dir[k];
+        ++v;
+      }
+    }
+    tpl.outlineCount = v;
+  }
+}
+
+MazeRenderer::Chunk &MazeRenderer::chunkAt(int row, int col)
+{
+  return m_chunks[static_cast<std::size_t>(row / CHUNK_SIZE) * m_chunkCols + col / CHUNK_SIZE];
+}
+
+void MazeRenderer::markDirty(Chunk &chunk, std::size_t first, std::size_t count)
+{
+  if (chunk.dirtyEnd <= chunk.dirtyBegin)
+  {
+    chunk.dirtyBegin = first;
+    chunk.dirtyEnd = first + count;
+    return;
+  }
+  chunk.dirtyBegin = std::min(chunk.dirtyBegin, first);
+  chunk.dirtyEnd = std::max(chunk.dirtyEnd, first + count);
+}
+
+void MazeRenderer::collapseSlot(Chunk &chunk, int row, int col, std::size_t first)
+{
+  const std::size_t tile = static_cast<std::size_t>(row) * m_cols + col;
+  const std::size_t slot = static_cast<std::size_t>(m_tileSlot[tile]);
+  const std::size_t capacity = m_tileCapacity[tile];
+  if (first >= capacity)
+    return;
+
+  const sf::Vector2f origin(col * m_tileSize, row * m_tileSize);
+  for (std::size_t i = slot + first; i < slot + capacity; ++i)
+  {
+    chunk.vertices[i].position = origin;
+    chunk.vertices[i].color = sf::Color::Transparent;
+  }
+  markDirty(chunk, slot + first, capacity - first);
+}
+
+void MazeRenderer::setTile(int row, int col, std::uint8_t cornerMask, sf::Color fill, sf::Color outline, float outlineThickness)
+{
+  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols)
+    return;
+
+  const TileTemplate &tpl = m_templates[cornerMask & 0xF];
+  const std::size_t needed = tpl.fillCount + tpl.outlineCount;
+  const std::size_t tile = static_cast<std::size_t>(row) * m_cols + col;
+  Chunk &chunk = chunkAt(row, col);
+
+  // 槽不够大（第一次放墙或圆角变多）：旧槽收缩为退化三角形，在分块末尾分配新槽
+  // 槽只会变大，每个格子最多换 4 次槽
+  if (m_tileSlot[tile] < 0 || m_tileCapacity[tile] < needed)
+  {
+    if (m_tileSlot[tile] >= 0)
+      collapseSlot(chunk, row, col, 0);
+    m_tileSlot[tile] = static_cast<int>(chunk.vertices.size());
+    m_tileCapacity[tile] = static_cast<std::uint16_t>(needed);
+    chunk.vertices.resize(chunk.vertices.size() + needed);
+  }
+  m_tileMask[tile] = cornerMask & 0xF;
+
+  const std::size_t slot = static_cast<std::size_t>(m_tileSlot[tile]);
+  sf::Vertex *vertices = &chunk.vertices[slot];
+  const sf::Vector2f origin(col * m_tileSize, row * m_tileSize);
+
+  for (std::size_t i = 0; i < tpl.fillCount; ++i)
+  {
+    vertices[i].position = origin + tpl.fill[i];
+    vertices[i].color = fill;
+  }
+
+  for (std::size_t i = 0; i < tpl.outlineCount; ++i)
+  {
+    sf::Vertex &vertex = vertices[tpl.fillCount + i];
+    vertex.position = origin + tpl.outlineBase[i] + tpl.outlineNormal[i] * outlineThickness;
+    vertex.color = outline;
+  }
+
+  markDirty(chunk, slot, needed);
+  // 圆角变少时槽尾部多出来的顶点
+  collapseSlot(chunk, row, col, needed);
+}
+
+void MazeRenderer::setTileFill(int row, int col, sf::Color fill)
+{
+  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols)
+    return;
+
+  const std::size_t tile = static_cast<std::size_t>(row) * m_cols + col;
+  if (m_tileSlot[tile] < 0)
+    return;
+
+  Chunk &chunk = chunkAt(row, col);
+  const std::size_t slot = static_cast<std::size_t>(m_tileSlot[tile]);
+  const std::size_t fillCount = m_templates[m_tileMask[tile]].fillCount;
+  for (std::size_t i = slot; i < slot + fillCount; ++i)
+  {
+    chunk.vertices[i].color = fill;
+  }
+  markDirty(chunk, slot, fillCount);
+}
+
+void MazeRenderer::clearTile(int row, int col)
+{
+  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols)
+    return;
+
+  // 保留槽位（重新放墙时复用），只把顶点收缩到同一点
+  if (m_tileSlot[static_cast<std::size_t>(row) * m_cols + col] >= 0)
+    collapseSlot(chunkAt(row, col), row, col, 0);
+}
+
+bool MazeRenderer::upload(const Chunk &chunk)
+{
+  const std::size_t count = chunk.vertices.size();
+  if (!chunk.buffer)
+  {
+    chunk.buffer = std::make_unique<sf::VertexBuffer>(sf::PrimitiveType::Triangles, sf::VertexBuffer::Usage::Dynamic);
+  }
+
+  if (chunk.buffer->getVertexCount() < count)
+  {
+    // 缓冲不够大（首次绘制或分块追加了新槽）：按容量重建并整体上传
+    if (!chunk.buffer->create(chunk.vertices.capacity()) || !chunk.buffer->update(chunk.vertices.data(), count, 0))
+      return false;
+  }
+  else if (chunk.dirtyEnd > chunk.dirtyBegin)
+  {
+    // 只上传改动过的范围
+    if (!chunk.buffer->update(chunk.vertices.data() + chunk.dirtyBegin, chunk.dirtyEnd - chunk.dirtyBegin,
+                              static_cast<unsigned int>(chunk.dirtyBegin)))
+      return false;
+  }
+
+  chunk.dirtyBegin = 0;
+  chunk.dirtyEnd = 0;
+  return true;
+}
+
+void MazeRenderer::draw(sf::RenderTarget &target, const TileRange &visible) const
+{
+  if (visible.maxRow < visible.minRow || visible.maxCol < visible.minCol)
+    return;
+
+  const int minChunkRow = std::max(0, visible.minRow / CHUNK_SIZE);
+  const int maxChunkRow = std::min(m_chunkRows - 1, visible.maxRow / CHUNK_SIZE);
+  const int minChunkCol = std::max(0, visible.minCol / CHUNK_SIZE);
+  const int maxChunkCol = std::min(m_chunkCols - 1, visible.maxCol / CHUNK_SIZE);
+  const bool useBuffers = sf::VertexBuffer::isAvailable();
+
+  for (int cr = minChunkRow; cr <= maxChunkRow; ++cr)
+  {
+    for (int cc = minChunkCol; cc <= maxChunkCol; ++cc)
+    {
+      const Chunk &chunk = m_chunks[static_cast<std::size_t>(cr) * m_chunkCols + cc];
+      if (chunk.vertices.empty())
+        continue;
+
+      if (useBuffers && upload(chunk))
+      {
+        target.draw(*chunk.buffer, 0, chunk.vertices.size());
+      }
+      else
+      {
+        // 不支持顶点缓冲时直接提交内存中的顶点
+        target.draw(chunk.vertices.data(), chunk.vertices.size(), sf::PrimitiveType::Triangles);
+      }
+    }
+  }
+}